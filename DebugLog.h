@@ -6,9 +6,13 @@
 #include <Arduino.h>
 #include <stdarg.h>
 #else
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string.h>
+#include <vector>
 #endif
 
 #include <ArxTypeTraits.h>
@@ -19,23 +23,77 @@
 namespace DebugLog = arx::debug;
 using DebugLogLevel = arx::debug::LogLevel;
 using DebugLogBase = arx::debug::LogBase;
-#ifdef ARDUINO
 using DebugLogPrecision = arx::debug::LogPrecision;
-#endif
+using DebugLogOverflow = arx::debug::OverflowPolicy;
+using DebugLogTimestamp = arx::debug::LogTimestamp;
 
 // PRINT and PRINTLN are always enabled regardless of log_level
 // PRINT and PRINTLN do NOT print to files
 #define PRINT(...) DebugLog::Manager::get().print(__VA_ARGS__)
 #define PRINTLN(...) DebugLog::Manager::get().println(__VA_ARGS__)
 #define LOG_AS_ARR(arr, sz) DebugLog::to_arr(arr, sz)
+#define LOG_AS_HEXDUMP(ptr, sz) DebugLog::to_hexdump(ptr, sz)
 #define LOG_GET_LEVEL() DebugLog::Manager::get().log_level()
 #define LOG_SET_LEVEL(l) DebugLog::Manager::get().log_level(l)
 #define LOG_SET_DELIMITER(d) DebugLog::Manager::get().delimiter(d)
 #define LOG_SET_BASE_RESET(b) DebugLog::Manager::get().base_reset(b)
+// arrays / containers and LOG_AS_HEXDUMP are cut with "... (N more)" (0: unlimited)
+#define LOG_SET_MAX_ELEMENTS(n) DebugLog::Manager::get().max_elements(n)
+#define LOG_SET_MAX_BYTES(n) DebugLog::Manager::get().max_bytes(n)
+// LOG_SET_OVERFLOW_POLICY(policy [, level]) when the async queue (C++) or Serial TX buffer (Arduino) is full
+#define LOG_SET_OVERFLOW_POLICY(...) DebugLog::Manager::get().overflow_policy(__VA_ARGS__)
+// LOG_GET_DROPPED([level]) returns the number of records dropped by the overflow policy
+#define LOG_GET_DROPPED(...) DebugLog::Manager::get().dropped(__VA_ARGS__)
+// flight recorder: the last records down to the recorder level (default: TRACE on C++, disabled on Arduino)
+// are kept in memory and dumped by ASSERT, LOG_DUMP_RECORDER() and fatal signals (C++)
+#define LOG_GET_RECORDER_LEVEL() DebugLog::Manager::get().recorder_level()
+#define LOG_SET_RECORDER_LEVEL(l) DebugLog::Manager::get().recorder_level(l)
+#define LOG_RECORDER_FOLLOW_OUTPUTS() DebugLog::Manager::get().recorder_follow_outputs()
+#define LOG_DUMP_RECORDER() DebugLog::Manager::get().dump_recorder()
+// identical consecutive LOG_XXXX are written once to each output and "last message repeated N times" is written
+// before the next different record or every interval_ms while repeating (0: disabled)
+#define LOG_GET_COALESCE() DebugLog::Manager::get().coalesce()
+#define LOG_SET_COALESCE(interval_ms) DebugLog::Manager::get().coalesce(interval_ms)
+// LOG_SET_TIMESTAMP(kind [, digits]) adds the timestamp with 0, 3, 6 or 9 digits of a second after the level tag
+#define LOG_GET_TIMESTAMP() DebugLog::Manager::get().timestamp()
+#define LOG_SET_TIMESTAMP(...) DebugLog::Manager::get().timestamp(__VA_ARGS__)
+#ifdef DEBUGLOG_HAS_SITE_FILTER
+// call sites matching the pattern ("file:<name>", "func:<name>" and "line:<n>" separated by spaces, "*" is a wildcard)
+// are written up to the level regardless of LOG_SET_LEVEL() and disabled above it
+#define LOG_SET_SITE_LEVEL(pattern, l) DebugLog::Manager::get().site_level(pattern, l)
+#define LOG_ENABLE_SITES(pattern) DebugLog::Manager::get().site_level(pattern, DebugLogLevel::LVL_TRACE)
+#define LOG_DISABLE_SITES(pattern) DebugLog::Manager::get().site_level(pattern, DebugLogLevel::LVL_NONE)
+#define LOG_RESET_SITES() DebugLog::Manager::get().reset_sites()
+#define LOG_PRINT_SITES() DebugLog::Manager::get().print_sites()
+#endif
 
-#ifdef ARDUINO
-#define LOG_ATTACH_SERIAL(s) DebugLog::Manager::get().attach(s)
-#define LOG_ATTACH_STREAM(s) DebugLog::Manager::get().attach(s)
+// rate limited LOG_XXXX: each call site has its own counter / timer / token bucket
+// LOG_XXXX_EVERY_N(n, ...)       : 1st, (n+1)th, (2n+1)th ... calls
+// LOG_XXXX_FIRST_N(n, ...)       : first n calls
+// LOG_XXXX_EVERY_MS(ms, ...)     : at most once per ms milliseconds
+// LOG_XXXX_RATE(per_sec, burst, ...) : token bucket of per_sec messages per second and burst messages at once
+#define LOG_ERROR_EVERY_N(n, ...) LOG_LIMITED_ERROR(every_n(n), __VA_ARGS__)
+#define LOG_ERROR_FIRST_N(n, ...) LOG_LIMITED_ERROR(first_n(n), __VA_ARGS__)
+#define LOG_ERROR_EVERY_MS(ms, ...) LOG_LIMITED_ERROR(every_ms(ms), __VA_ARGS__)
+#define LOG_ERROR_RATE(per_sec, burst, ...) LOG_LIMITED_ERROR(rate(per_sec, burst), __VA_ARGS__)
+#define LOG_WARN_EVERY_N(n, ...) LOG_LIMITED_WARN(every_n(n), __VA_ARGS__)
+#define LOG_WARN_FIRST_N(n, ...) LOG_LIMITED_WARN(first_n(n), __VA_ARGS__)
+#define LOG_WARN_EVERY_MS(ms, ...) LOG_LIMITED_WARN(every_ms(ms), __VA_ARGS__)
+#define LOG_WARN_RATE(per_sec, burst, ...) LOG_LIMITED_WARN(rate(per_sec, burst), __VA_ARGS__)
+#define LOG_INFO_EVERY_N(n, ...) LOG_LIMITED_INFO(every_n(n), __VA_ARGS__)
+#define LOG_INFO_FIRST_N(n, ...) LOG_LIMITED_INFO(first_n(n), __VA_ARGS__)
+#define LOG_INFO_EVERY_MS(ms, ...) LOG_LIMITED_INFO(every_ms(ms), __VA_ARGS__)
+#define LOG_INFO_RATE(per_sec, burst, ...) LOG_LIMITED_INFO(rate(per_sec, burst), __VA_ARGS__)
+#define LOG_DEBUG_EVERY_N(n, ...) LOG_LIMITED_DEBUG(every_n(n), __VA_ARGS__)
+#define LOG_DEBUG_FIRST_N(n, ...) LOG_LIMITED_DEBUG(first_n(n), __VA_ARGS__)
+#define LOG_DEBUG_EVERY_MS(ms, ...) LOG_LIMITED_DEBUG(every_ms(ms), __VA_ARGS__)
+#define LOG_DEBUG_RATE(per_sec, burst, ...) LOG_LIMITED_DEBUG(rate(per_sec, burst), __VA_ARGS__)
+#define LOG_TRACE_EVERY_N(n, ...) LOG_LIMITED_TRACE(every_n(n), __VA_ARGS__)
+#define LOG_TRACE_FIRST_N(n, ...) LOG_LIMITED_TRACE(first_n(n), __VA_ARGS__)
+#define LOG_TRACE_EVERY_MS(ms, ...) LOG_LIMITED_TRACE(every_ms(ms), __VA_ARGS__)
+#define LOG_TRACE_RATE(per_sec, burst, ...) LOG_LIMITED_TRACE(rate(per_sec, burst), __VA_ARGS__)
+
+#if defined(ARDUINO) || defined(DEBUGLOG_HAS_MMAP_FILE_LOGGER)
 // PRINT_FILE and PRINTLN_FILE are always enabled regardless of file_level
 // PRINT_FILE and PRINTLN_FILE do NOT print to Serial
 #define PRINT_FILE(...) DebugLog::Manager::get().print_file(__VA_ARGS__)
@@ -45,10 +103,53 @@ using DebugLogPrecision = arx::debug::LogPrecision;
 #define LOG_FILE_IS_OPEN() DebugLog::Manager::get().is_open()
 #define LOG_FILE_GET_LEVEL() DebugLog::Manager::get().file_level()
 #define LOG_FILE_SET_LEVEL(l) DebugLog::Manager::get().file_level(l)
+#endif
+
+#ifdef ARDUINO
+#define LOG_ATTACH_SERIAL(s) DebugLog::Manager::get().attach(s)
+#define LOG_ATTACH_STREAM(s) DebugLog::Manager::get().attach(s)
 #if defined(FILE_WRITE) && defined(DEBUGLOG_ENABLE_FILE_LOGGER)
 #define LOG_ATTACH_FS_AUTO(fs, path, mode) DebugLog::Manager::get().attach(fs, path, mode, true)
 #define LOG_ATTACH_FS_MANUAL(fs, path, mode) DebugLog::Manager::get().attach(fs, path, mode, false)
 #endif
+// LOG_FILE_SET_FLUSH_POLICY(bytes [, records [, interval_ms]]) for LOG_ATTACH_FS_AUTO (0 disables each threshold)
+#define LOG_FILE_SET_FLUSH_POLICY(...) DebugLog::Manager::get().file_flush_policy(DebugLog::FlushPolicy(__VA_ARGS__))
+#else
+// LOG_XXXX, PRINT and PRINTLN are written by the background thread after LOG_ASYNC_START()
+#define LOG_ASYNC_START(...) DebugLog::Manager::get().async_start(__VA_ARGS__)
+#define LOG_ASYNC_STOP() DebugLog::Manager::get().async_stop()
+#define LOG_ASYNC_FLUSH() DebugLog::Manager::get().async_flush()
+#define LOG_IS_ASYNC() DebugLog::Manager::get().is_async()
+// LOG_XXXX are written to the binary file if DEBUGLOG_ENABLE_BINARY_LOG is defined
+#define LOG_BINARY_ATTACH(path) DebugLog::Manager::get().binary_attach(path)
+#define LOG_BINARY_FLUSH() DebugLog::Manager::get().binary_flush()
+#define LOG_BINARY_CLOSE() DebugLog::Manager::get().binary_close()
+#define LOG_BINARY_IS_OPEN() DebugLog::Manager::get().is_binary_open()
+// LOG_ADD_SINK(std::shared_ptr<Sink> [, level [, std::shared_ptr<Formatter> [, queue_bytes]]]) returns the id of the sink
+#define LOG_ADD_SINK(...) DebugLog::Manager::get().add_sink(__VA_ARGS__)
+#define LOG_REMOVE_SINK(id) DebugLog::Manager::get().remove_sink(id)
+#define LOG_GET_SINK_LEVEL(id) DebugLog::Manager::get().sink_level(id)
+#define LOG_SET_SINK_LEVEL(id, l) DebugLog::Manager::get().sink_level(id, l)
+#define LOG_FLUSH_SINKS() DebugLog::Manager::get().flush_sinks()
+#define LOG_SET_SINK_OVERFLOW_POLICY(id, ...) DebugLog::Manager::get().sink_overflow_policy(id, __VA_ARGS__)
+#define LOG_GET_SINK_DROPPED(...) DebugLog::Manager::get().sink_dropped(__VA_ARGS__)
+// counters and latency histograms (recorded only if DEBUGLOG_ENABLE_STATS is defined)
+#define LOG_GET_STATS() DebugLog::Manager::get().stats()
+#define LOG_SET_STATS_REPORT_INTERVAL(ms) DebugLog::Manager::get().stats_report_interval(ms)
+// LOG_TRACE_EXPORT(path or std::ostream) writes LOG_SCOPE and LOG_TRACE_BEGIN / END events as Chrome trace JSON
+#define LOG_TRACE_EXPORT(dst) DebugLog::Manager::get().trace_export(dst)
+// the events recorded so far are discarded (e.g. after LOG_TRACE_EXPORT()) and their memory is released
+#define LOG_TRACE_CLEAR() DebugLog::Manager::get().trace_clear()
+// strftime() format of the date and time of DebugLogTimestamp::LOCAL and UTC
+#define LOG_SET_TIMESTAMP_FORMAT(fmt) DebugLog::Manager::get().timestamp_format(fmt)
+#ifdef DEBUGLOG_HAS_CRASH_HANDLER
+// dump the flight recorder to stderr on SIGSEGV, SIGABRT, SIGBUS, SIGFPE and SIGILL
+#define LOG_RECORDER_HANDLE_SIGNALS() DebugLog::Manager::get().recorder_handle_signals()
+#endif
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+// LOG_ATTACH_FILE(path [, segment_size [, max_files]])
+#define LOG_ATTACH_FILE(...) DebugLog::Manager::get().attach(__VA_ARGS__)
+#endif
 #endif  // ARDUINO
 
 #include "DebugLogRestoreState.h"
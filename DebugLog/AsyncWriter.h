@@ -0,0 +1,364 @@
+#pragma once
+#ifndef DEBUGLOG_ASYNC_WRITER_H
+#define DEBUGLOG_ASYNC_WRITER_H
+
+#ifndef ARDUINO
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+#include "Sink.h"
+#include "DropCounter.h"
+#include "Stats.h"
+
+#ifndef DEBUGLOG_ASYNC_BUFFER_SIZE
+#define DEBUGLOG_ASYNC_BUFFER_SIZE (1 << 20)
+#endif
+
+// records are written to the sink in batches of about this size
+#ifndef DEBUGLOG_ASYNC_BATCH_SIZE
+#define DEBUGLOG_ASYNC_BATCH_SIZE 4096
+#endif
+
+namespace arx {
+namespace debug {
+
+    // Lock-free multi-producer / single-consumer ring of fixed size slots.
+    // One record occupies one or more consecutive slots.
+    // Consumers (the writer and producers which discard the oldest record) are serialized by the caller.
+    // Slot sequence numbers follow the bounded MPMC queue by D. Vyukov:
+    // seq == pos : free for the producer at pos
+    // seq == pos + 1 : published for the consumer at pos
+    class RecordRing {
+    public:
+        static constexpr size_t SLOT_DATA_SIZE {48};
+
+    private:
+        struct Slot {
+            std::atomic<size_t> seq;
+            size_t len;  // total record length, valid only in the first slot of the record
+            LogLevel level;  // valid only in the first slot of the record
+            char data[SLOT_DATA_SIZE];
+        };
+
+        std::vector<Slot> slots;
+        size_t mask;
+        char pad0[64];  // keep head and tail in separate cache lines
+        std::atomic<size_t> head {0};
+        char pad1[64];
+        size_t tail {0};
+
+    public:
+        explicit RecordRing(const size_t n_bytes) {
+            allocate(n_bytes);
+        }
+
+        // only while no producer nor consumer uses the ring and it is empty
+        // positions continue from the last record, so they never go backwards
+        void allocate(const size_t n_bytes) {
+            std::vector<Slot>(round_up_pow2(n_bytes / SLOT_DATA_SIZE)).swap(slots);
+            mask = slots.size() - 1;
+            for (size_t i = 0; i < slots.size(); ++i)
+                slots[(tail + i) & mask].seq.store(tail + i, std::memory_order_relaxed);
+        }
+
+        // only while no producer nor consumer uses the ring
+        void release() {
+            std::vector<Slot>().swap(slots);
+        }
+
+        size_t capacity_bytes() const { return slots.size() * SLOT_DATA_SIZE; }
+
+        // position which will be claimed by the next producer
+        size_t head_pos() const { return head.load(std::memory_order_acquire); }
+
+        // returns false if the ring is full (nothing is written)
+        // `len` must not exceed capacity_bytes() (AsyncWriter drops such records)
+        bool try_push(const char* data, size_t len, const LogLevel level = LogLevel::LVL_NONE) {
+            const size_t n_slots = len ? (len + SLOT_DATA_SIZE - 1) / SLOT_DATA_SIZE : 1;
+
+            size_t pos = head.load(std::memory_order_relaxed);
+            while (true) {
+                // slots are released in order, so if the last one is free all of them are free
+                const size_t last = pos + n_slots - 1;
+                const size_t seq = slots[last & mask].seq.load(std::memory_order_acquire);
+                const intptr_t diff = (intptr_t)seq - (intptr_t)last;
+                if (diff == 0) {
+                    if (head.compare_exchange_weak(pos, pos + n_slots, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+
+            slots[pos & mask].len = len;
+            slots[pos & mask].level = level;
+            for (size_t i = 0; i < n_slots; ++i) {
+                const size_t n = (len > SLOT_DATA_SIZE) ? SLOT_DATA_SIZE : len;
+                memcpy(slots[(pos + i) & mask].data, data, n);
+                data += n;
+                len -= n;
+            }
+            // publish in reverse order: the consumer only looks at the first slot
+            for (size_t i = n_slots; i > 0; --i)
+                slots[(pos + i - 1) & mask].seq.store(pos + i, std::memory_order_release);
+            return true;
+        }
+
+        // single consumer only: appends one record to `out` and returns false if empty
+        bool try_pop(std::vector<char>& out) {
+            LogLevel level;
+            return pop(&out, level);
+        }
+
+        // single consumer only: releases the oldest record without reading it
+        bool discard(LogLevel& level) {
+            return pop(nullptr, level);
+        }
+
+        // single consumer only
+        size_t tail_pos() const { return tail; }
+
+    private:
+        bool pop(std::vector<char>* out, LogLevel& level) {
+            Slot& first = slots[tail & mask];
+            if (first.seq.load(std::memory_order_acquire) != tail + 1) return false;
+
+            size_t len = first.len;
+            level = first.level;
+            const size_t n_slots = len ? (len + SLOT_DATA_SIZE - 1) / SLOT_DATA_SIZE : 1;
+            for (size_t i = 0; i < n_slots; ++i) {
+                Slot& s = slots[(tail + i) & mask];
+                const size_t n = (len > SLOT_DATA_SIZE) ? SLOT_DATA_SIZE : len;
+                if (out) out->insert(out->end(), s.data, s.data + n);
+                len -= n;
+                s.seq.store(tail + i + slots.size(), std::memory_order_release);
+            }
+            tail += n_slots;
+            return true;
+        }
+
+        static size_t round_up_pow2(const size_t n) {
+            size_t p = 2;
+            while (p < n) p <<= 1;
+            return p;
+        }
+    };
+
+    // Background writer which drains RecordRing into the sink in batches
+    // When the ring is full, a new record is handled by OverflowPolicy. Records dropped by the policy
+    // are reported to the sink as one WARN record after the next batch is written.
+    class AsyncWriter {
+        RecordRing ring;
+        std::unique_ptr<Sink> owned;
+        Sink* sink;
+        std::shared_ptr<Formatter> formatter;  // used for the report of dropped records
+        size_t batch_bytes;
+        RelaxedAtomic<OverflowPolicy> policy {OverflowPolicy::BLOCK};
+        RelaxedAtomic<LogLevel> policy_lvl {LogLevel::LVL_WARN};
+        DropCounter drops;
+        std::mutex pop_mtx;  // the writer and producers which discard the oldest record
+        std::thread th;
+        std::atomic<bool> b_running {true};
+        std::atomic<bool> b_sleeping {false};
+        std::atomic<int> n_pushing {0};  // producers between the running check and the end of push
+        std::atomic<size_t> written_pos {0};
+        std::mutex mtx;
+        std::condition_variable cv;
+
+    public:
+        AsyncWriter(std::ostream* s, const size_t n_bytes)
+        : ring(n_bytes), owned(new OstreamSink(*s)), sink(owned.get()), batch_bytes(DEBUGLOG_ASYNC_BATCH_SIZE) {
+            th = std::thread([this] { run(); });
+        }
+
+        AsyncWriter(Sink* s, const size_t n_bytes, const std::shared_ptr<Formatter>& formatter = nullptr, const size_t batch_bytes = DEBUGLOG_ASYNC_BATCH_SIZE)
+        : ring(n_bytes), sink(s), formatter(formatter), batch_bytes(batch_bytes ? batch_bytes : 1) {
+            th = std::thread([this] { run(); });
+        }
+
+        ~AsyncWriter() {
+            stop();
+        }
+
+        bool is_running() const {
+            return b_running.load(std::memory_order_acquire);
+        }
+
+        // `level` is the least severe level which is not dropped by OverflowPolicy::DROP_BELOW
+        void overflow_policy(const OverflowPolicy p, const LogLevel level = LogLevel::LVL_WARN) {
+            policy_lvl.store(level);
+            policy.store(p);
+        }
+
+        OverflowPolicy overflow_policy() const {
+            return policy.load();
+        }
+
+        const DropCounter& dropped() const {
+            return drops;
+        }
+
+        // if the ring is full, waits (spins with yield) or drops a record depending on OverflowPolicy
+        // a record longer than the ring is always dropped (and counted)
+        // returns false if the writer has been stopped and the record was neither queued nor dropped
+        bool push(const char* data, const size_t len, const LogLevel level = LogLevel::LVL_NONE) {
+            n_pushing.fetch_add(1);
+            bool b_pushed = b_running.load();
+            if (b_pushed && len > ring.capacity_bytes()) {
+                drops.add(level);
+                n_pushing.fetch_sub(1);
+                return true;
+            }
+            while (b_pushed && !ring.try_push(data, len, level)) {
+                if (discard_oldest()) continue;
+                if (drop_new(level)) break;
+                b_pushed = b_running.load();
+                wake();
+                std::this_thread::yield();
+            }
+            n_pushing.fetch_sub(1);
+            if (b_pushed && b_sleeping.load(std::memory_order_relaxed)) wake();
+            return b_pushed;
+        }
+
+        // waits until all records pushed before this call are written to the sink
+        void flush() {
+            const size_t target = ring.head_pos();
+            while (is_running() && written_pos.load(std::memory_order_acquire) < target) {
+                wake();
+                std::this_thread::yield();
+            }
+        }
+
+        // drains all records, joins the writer thread and releases the ring
+        void stop() {
+            if (!th.joinable()) return;
+            b_running.store(false);
+            wake();
+            th.join();
+            ring.release();
+        }
+
+        // starts the stopped writer again with a new ring (the counters of dropped records are reset)
+        void restart(const size_t n_bytes) {
+            if (th.joinable()) return;
+            ring.allocate(n_bytes);
+            drops.reset();
+            b_running.store(true);
+            th = std::thread([this] { run(); });
+        }
+
+    private:
+        // OverflowPolicy::DROP_OLDEST: returns true if there may be space for the new record
+        bool discard_oldest() {
+            if (policy.load() != OverflowPolicy::DROP_OLDEST) return false;
+            std::lock_guard<std::mutex> lock(pop_mtx);
+            LogLevel level;
+            if (ring.discard(level)) drops.add(level);
+            return true;
+        }
+
+        // OverflowPolicy::DROP_NEWEST / DROP_BELOW: returns true if the new record is dropped
+        bool drop_new(const LogLevel level) {
+            const OverflowPolicy p = policy.load();
+            const bool b_drop = (p == OverflowPolicy::DROP_NEWEST)
+                || (p == OverflowPolicy::DROP_BELOW && (int)level > (int)policy_lvl.load());
+            if (b_drop) drops.add(level);
+            return b_drop;
+        }
+
+        // "[WARN] DebugLog : 12 records dropped (INFO 10, TRACE 2)"
+        void report_drops() {
+            uint32_t n[DropCounter::N_LEVELS];
+            const uint32_t sum = drops.take_unreported(n);
+            if (sum == 0) return;
+            std::string body = "DebugLog : " + std::to_string(sum) + " records dropped (";
+            bool b_first = true;
+            for (size_t i = 0; i < DropCounter::N_LEVELS; ++i) {
+                if (n[i] == 0) continue;
+                if (!b_first) body += ", ";
+                body += std::string(DropCounter::label(i)) + " " + std::to_string(n[i]);
+                b_first = false;
+            }
+            body += ")\n";
+            static constexpr char header[] = "[WARN] ";
+            std::string line;
+            if (formatter) {
+                const Record r {LogLevel::LVL_WARN, header, sizeof(header) - 1, body.data(), body.size(), body.data(), 0};
+                formatter->format(r, line);
+            } else {
+                line = header + body;
+            }
+            sink->write(line.data(), line.size());
+        }
+
+        void wake() {
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_one();
+        }
+
+        void run() {
+            std::vector<char> buf;
+            buf.reserve(batch_bytes);
+            bool b_last = false;  // no producer can push any more, so this drain is the last one
+            while (true) {
+                const bool b_running_now = b_running.load();
+                buf.clear();
+                size_t pos = 0;
+                {
+                    std::lock_guard<std::mutex> lock(pop_mtx);
+                    while (buf.size() < buf.capacity() && ring.try_pop(buf))
+                        ;
+                    pos = ring.tail_pos();
+                }
+                if (!buf.empty()) {
+                    const uint64_t t0 = stats::now_ns();
+                    sink->write(buf.data(), buf.size());
+                    if (owned) stats::on_stream_write(buf.size(), t0);  // the writer of std::cout
+                    else stats::on_sink_write(buf.size(), t0);
+                    report_drops();
+                    sink->flush();
+                    stats::on_flush();
+                    written_pos.store(pos, std::memory_order_release);
+                    continue;
+                }
+                report_drops();  // the rest of the records may have been discarded by DROP_OLDEST
+                written_pos.store(pos, std::memory_order_release);
+                // stop was requested before this drain: producers which saw b_running may still be pushing,
+                // so the ring is drained once more after all of them have finished
+                if (!b_running_now) {
+                    if (b_last) break;
+                    if (n_pushing.load() == 0)
+                        b_last = true;
+                    else
+                        std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mtx);
+                b_sleeping.store(true, std::memory_order_relaxed);
+                cv.wait_for(lock, std::chrono::milliseconds(10));
+                b_sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_ASYNC_WRITER_H
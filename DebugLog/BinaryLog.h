@@ -0,0 +1,545 @@
+#pragma once
+#ifndef DEBUGLOG_BINARY_LOG_H
+#define DEBUGLOG_BINARY_LOG_H
+
+#ifndef ARDUINO
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "NumberFormat.h"
+
+// Binary log format (native endianness)
+//
+// file   : "DLOGBIN1" entry*
+// entry  : 'S' u32 id, u8 level, u32 line, str file, str func, str signature  (call site definition)
+//        | 'D' str delimiter
+//        | 'F' u8 base, i8 precision  (format state of the thread before the next 'R' if it is not the default)
+//        | 'R' u32 id, value*  (one value for each type in the signature of the call site)
+// str    : u32 length, bytes
+//
+// signature is the list of type tags of the arguments
+// 'b' bool, 'c' char, 'a' signed char, 'h' unsigned char,
+// 's' short, 't' unsigned short, 'i' int, 'j' unsigned int, 'l' long, 'm' unsigned long,
+// 'x' long long, 'y' unsigned long long, 'f' float, 'd' double, 'e' long double,
+// 'S' string (str), 'A' + element tag (u32 count, values), 'M' + key tag + value tag (u32 count, pairs)
+// 'B' LogBase (u8), 'P' LogPrecision (u8) : change the format of the following values and print nothing
+// Other types are formatted with operator<< when logging and stored as 'S'
+
+namespace arx {
+namespace debug {
+
+    static constexpr char BINARY_LOG_MAGIC[] = "DLOGBIN1";
+
+    namespace binary {
+
+        inline void put_raw(std::string& buf, const void* p, const size_t n) {
+            buf.append(static_cast<const char*>(p), n);
+        }
+
+        inline void put_u32(std::string& buf, const uint32_t v) {
+            put_raw(buf, &v, sizeof(v));
+        }
+
+        inline void put_str(std::string& buf, const char* s, const size_t n) {
+            put_u32(buf, (uint32_t)n);
+            put_raw(buf, s, n);
+        }
+
+        // fallback: format with operator<< and store as string
+        template <typename T, typename Enable = void>
+        struct Codec {
+            static void sig(std::string& s) { s += 'S'; }
+            static void put(std::string& buf, const T& v) {
+                std::ostringstream os;
+                os << v;
+                const std::string str = os.str();
+                put_str(buf, str.data(), str.size());
+            }
+        };
+
+#define DEBUGLOG_BINARY_CODEC_ARITHMETIC(type, tag)                                 \
+    template <>                                                                     \
+    struct Codec<type> {                                                            \
+        static void sig(std::string& s) { s += tag; }                               \
+        static void put(std::string& buf, const type& v) { put_raw(buf, &v, sizeof(v)); } \
+    };
+
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(bool, 'b')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(char, 'c')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(signed char, 'a')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(unsigned char, 'h')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(short, 's')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(unsigned short, 't')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(int, 'i')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(unsigned int, 'j')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(long, 'l')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(unsigned long, 'm')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(long long, 'x')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(unsigned long long, 'y')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(float, 'f')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(double, 'd')
+        DEBUGLOG_BINARY_CODEC_ARITHMETIC(long double, 'e')
+
+#undef DEBUGLOG_BINARY_CODEC_ARITHMETIC
+
+        template <>
+        struct Codec<LogBase> {
+            static void sig(std::string& s) { s += 'B'; }
+            static void put(std::string& buf, const LogBase& v) { buf += (char)(uint8_t)v; }
+        };
+
+        template <>
+        struct Codec<LogPrecision> {
+            static void sig(std::string& s) { s += 'P'; }
+            static void put(std::string& buf, const LogPrecision& v) { buf += (char)(uint8_t)v; }
+        };
+
+        template <>
+        struct Codec<const char*> {
+            static void sig(std::string& s) { s += 'S'; }
+            static void put(std::string& buf, const char* v) { put_str(buf, v, strlen(v)); }
+        };
+
+        template <>
+        struct Codec<char*> : Codec<const char*> {};
+
+        template <>
+        struct Codec<std::string> {
+            static void sig(std::string& s) { s += 'S'; }
+            static void put(std::string& buf, const std::string& v) { put_str(buf, v.data(), v.size()); }
+        };
+
+        template <typename T>
+        struct ArrayCodec {
+            using value_t = typename std::decay<decltype(std::declval<T>()[0])>::type;
+            static void sig(std::string& s) {
+                s += 'A';
+                Codec<value_t>::sig(s);
+            }
+            static void put(std::string& buf, const T& v) {
+                put_u32(buf, (uint32_t)v.size());
+                for (size_t i = 0; i < v.size(); ++i)
+                    Codec<value_t>::put(buf, v[i]);
+            }
+        };
+
+        template <typename T>
+        struct Codec<Array<T>> : ArrayCodec<Array<T>> {};
+        template <typename T>
+        struct Codec<vec_t<T>> : ArrayCodec<vec_t<T>> {};
+        template <typename T>
+        struct Codec<deq_t<T>> : ArrayCodec<deq_t<T>> {};
+
+        template <typename K, typename V>
+        struct Codec<map_t<K, V>> {
+            static void sig(std::string& s) {
+                s += 'M';
+                Codec<K>::sig(s);
+                Codec<V>::sig(s);
+            }
+            static void put(std::string& buf, const map_t<K, V>& v) {
+                put_u32(buf, (uint32_t)v.size());
+                for (const auto& kv : v) {
+                    Codec<K>::put(buf, kv.first);
+                    Codec<V>::put(buf, kv.second);
+                }
+            }
+        };
+
+        template <typename T>
+        using codec_t = Codec<typename std::decay<T>::type>;
+
+        inline void signature(std::string&) {}
+
+        template <typename Head, typename... Tail>
+        inline void signature(std::string& s, const Head&, const Tail&... tail) {
+            codec_t<Head>::sig(s);
+            signature(s, tail...);
+        }
+
+        inline void encode(std::string&) {}
+
+        template <typename Head, typename... Tail>
+        inline void encode(std::string& buf, const Head& head, const Tail&... tail) {
+            codec_t<Head>::put(buf, head);
+            encode(buf, tail...);
+        }
+
+    }  // namespace binary
+
+    // static descriptor of one LOG_XXXX call site, registered once
+    struct BinarySite {
+        LogLevel level;
+        const char* file;
+        int line;
+        const char* func;
+        std::string signature;
+        std::atomic<uint32_t> id {0};  // 0: not registered yet
+
+        BinarySite(const LogLevel level, const char* file, const int line, const char* func)
+        : level(level), file(file), line(line), func(func) {}
+    };
+
+    class BinaryLogger {
+        std::ofstream ofs;
+        std::atomic<bool> b_open {false};
+
+    public:
+        BinaryLogger(const std::string& path, const string_t& delim)
+        : ofs(path, std::ios::binary | std::ios::trunc) {
+            std::lock_guard<std::mutex> lock(mutex());
+            ofs.write(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC) - 1);
+            write_delimiter(delim);
+            // call sites which have been registered to the previous logger
+            for (const BinarySite* site : sites())
+                write_site(*site);
+            b_open.store(ofs.is_open(), std::memory_order_release);
+        }
+
+        ~BinaryLogger() {
+            close();
+        }
+
+        bool is_open() const {
+            return b_open.load(std::memory_order_acquire);
+        }
+
+        // records logged after close() are discarded
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex());
+            b_open.store(false, std::memory_order_release);
+            if (ofs.is_open()) ofs.close();
+        }
+
+        void flush() {
+            std::lock_guard<std::mutex> lock(mutex());
+            ofs.flush();
+        }
+
+        void delimiter(const string_t& d) {
+            std::lock_guard<std::mutex> lock(mutex());
+            write_delimiter(d);
+        }
+
+        // `f` is the format state of the calling thread before the arguments
+        template <typename... Args>
+        void log(BinarySite& site, const FormatState& f, const Args&... args) {
+            uint32_t id = site.id.load(std::memory_order_acquire);
+            if (id == 0) id = register_site(site, args...);
+
+            static thread_local std::string buf;
+            buf.clear();
+            if (f.base != LogBase::DEC || f.precision >= 0) {
+                buf += 'F';
+                buf += (char)(uint8_t)f.base;
+                buf += (char)(int8_t)f.precision;
+            }
+            buf += 'R';
+            binary::put_u32(buf, id);
+            binary::encode(buf, args...);
+
+            std::lock_guard<std::mutex> lock(mutex());
+            ofs.write(buf.data(), buf.size());
+        }
+
+    private:
+        // call sites and their ids are shared by all loggers in the process
+        static std::vector<BinarySite*>& sites() {
+            static std::vector<BinarySite*> s;  // s[id - 1]
+            return s;
+        }
+
+        static std::mutex& mutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        template <typename... Args>
+        uint32_t register_site(BinarySite& site, const Args&... args) {
+            std::lock_guard<std::mutex> lock(mutex());
+            uint32_t id = site.id.load(std::memory_order_relaxed);
+            if (id != 0) return id;  // registered by another thread
+
+            binary::signature(site.signature, args...);
+            sites().push_back(&site);
+            id = (uint32_t)sites().size();
+            site.id.store(id, std::memory_order_release);
+            write_site(site);
+            return id;
+        }
+
+        void write_site(const BinarySite& site) {
+            std::string buf;
+            buf += 'S';
+            binary::put_u32(buf, site.id.load(std::memory_order_relaxed));
+            buf += (char)site.level;
+            binary::put_u32(buf, (uint32_t)site.line);
+            binary::put_str(buf, site.file, strlen(site.file));
+            binary::put_str(buf, site.func, strlen(site.func));
+            binary::put_str(buf, site.signature.data(), site.signature.size());
+            ofs.write(buf.data(), buf.size());
+        }
+
+        void write_delimiter(const string_t& d) {
+            std::string buf;
+            buf += 'D';
+            binary::put_str(buf, d.data(), d.size());
+            ofs.write(buf.data(), buf.size());
+        }
+    };
+
+    // Rebuilds the text which Manager::log would have printed from the binary log
+    class BinaryLogDecoder {
+        struct Site {
+            LogLevel level;
+            uint32_t line;
+            std::string file;
+            std::string func;
+            std::string signature;
+        };
+
+        std::istream& is;
+        std::vector<Site> sites;
+        std::string delim {" "};
+        FormatState state;
+
+    public:
+        explicit BinaryLogDecoder(std::istream& is)
+        : is(is) {}
+
+        // returns false if the input is not a binary log or is corrupted
+        bool decode(std::ostream& os) {
+            char magic[sizeof(BINARY_LOG_MAGIC) - 1];
+            if (!is.read(magic, sizeof(magic)) || memcmp(magic, BINARY_LOG_MAGIC, sizeof(magic)) != 0)
+                return false;
+
+            char tag;
+            while (is.get(tag)) {
+                switch (tag) {
+                    case 'S': {
+                        // ids are defined in order (and again in the same order by the next logger)
+                        uint32_t id;
+                        Site site;
+                        char level;
+                        if (!get(id) || id == 0 || id > sites.size() + 1) return false;
+                        if (!is.get(level) || !get(site.line)) return false;
+                        if (!get_str(site.file) || !get_str(site.func) || !get_str(site.signature)) return false;
+                        if (!is_valid_signature(site.signature)) return false;
+                        site.level = (LogLevel)level;
+                        if (id > sites.size()) sites.resize(id);
+                        sites[id - 1] = site;
+                        break;
+                    }
+                    case 'D': {
+                        if (!get_str(delim)) return false;
+                        break;
+                    }
+                    case 'F': {
+                        uint8_t base;
+                        int8_t precision;
+                        if (!get(base) || !get(precision)) return false;
+                        state.base = (LogBase)base;
+                        state.precision = precision;
+                        break;
+                    }
+                    case 'R': {
+                        uint32_t id;
+                        if (!get(id) || id == 0 || id > sites.size()) return false;
+                        const bool b_ok = decode_record(sites[id - 1], os);
+                        state = FormatState();  // the state of the next record is given by 'F'
+                        if (!b_ok) return false;
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        bool decode_record(const Site& site, std::ostream& os) {
+            switch (site.level) {
+                case LogLevel::LVL_ERROR: os << "[ERROR] "; break;
+                case LogLevel::LVL_WARN: os << "[WARN] "; break;
+                case LogLevel::LVL_INFO: os << "[INFO] "; break;
+                case LogLevel::LVL_DEBUG: os << "[DEBUG] "; break;
+                case LogLevel::LVL_TRACE: os << "[TRACE] "; break;
+                default: break;
+            }
+            os << site.file << delim << "L." << site.line << delim << site.func << delim << ":";
+            const char* sig = site.signature.c_str();
+            while (*sig) {
+                os << delim;
+                if (!decode_value(sig, os)) return false;
+            }
+            os << "\n";
+            return true;
+        }
+
+        bool decode_value(const char*& sig, std::ostream& os) {
+            switch (*sig++) {
+                case 'b': {
+                    uint8_t v;  // not read as bool, which must be 0 or 1
+                    if (!get(v)) return false;
+                    os << (v != 0);
+                    return true;
+                }
+                case 'c': return print_as<char>(os);
+                case 'a': return print_as<signed char>(os);
+                case 'h': return print_as<unsigned char>(os);
+                case 's': return print_number<short>(os);
+                case 't': return print_number<unsigned short>(os);
+                case 'i': return print_number<int>(os);
+                case 'j': return print_number<unsigned int>(os);
+                case 'l': return print_number<long>(os);
+                case 'm': return print_number<unsigned long>(os);
+                case 'x': return print_number<long long>(os);
+                case 'y': return print_number<unsigned long long>(os);
+                case 'f': return print_number<float>(os);
+                case 'd': return print_number<double>(os);
+                case 'e': return print_number<long double>(os);
+                case 'B': {
+                    uint8_t v;
+                    if (!get(v)) return false;
+                    state.base = (LogBase)v;
+                    return true;
+                }
+                case 'P': {
+                    uint8_t v;
+                    if (!get(v)) return false;
+                    state.precision = v;
+                    return true;
+                }
+                case 'S': {
+                    std::string s;
+                    if (!get_str(s)) return false;
+                    os << s;
+                    return true;
+                }
+                case 'A': {
+                    uint32_t n;
+                    if (!get(n)) return false;
+                    const char* elem = sig;
+                    os << "[";
+                    for (uint32_t i = 0; i < n; ++i) {
+                        sig = elem;
+                        if (!decode_value(sig, os)) return false;
+                        if (i + 1 != n) os << ", ";
+                    }
+                    os << "]";
+                    sig = skip_signature(elem);
+                    return true;
+                }
+                case 'M': {
+                    uint32_t n;
+                    if (!get(n)) return false;
+                    const char* key = sig;
+                    os << "{";
+                    for (uint32_t i = 0; i < n; ++i) {
+                        sig = key;
+                        if (!decode_value(sig, os)) return false;
+                        os << ":";
+                        if (!decode_value(sig, os)) return false;
+                        if (i + 1 != n) os << ", ";
+                    }
+                    os << "}";
+                    sig = skip_signature(skip_signature(key));
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        static const char* skip_signature(const char* sig) {
+            switch (*sig++) {
+                case 'A': return skip_signature(sig);
+                case 'M': return skip_signature(skip_signature(sig));
+                default: return sig;
+            }
+        }
+
+        // nullptr if `sig` does not start with one complete type
+        static const char* parse_type(const char* sig) {
+            switch (*sig++) {
+                case 'A': return parse_type(sig);
+                case 'M': {
+                    const char* value = parse_type(sig);
+                    return value ? parse_type(value) : nullptr;
+                }
+                case '\0': return nullptr;
+                default: return strchr("bcahstijlmxyfdeSBP", sig[-1]) ? sig : nullptr;
+            }
+        }
+
+        // LogBase and LogPrecision are not allowed in arrays and maps
+        static bool is_valid_signature(const std::string& signature) {
+            for (const char* sig = signature.c_str(); *sig;) {
+                const char* next = parse_type(sig);
+                if (!next) return false;
+                if (next - sig > 1 && (memchr(sig, 'B', (size_t)(next - sig)) || memchr(sig, 'P', (size_t)(next - sig)))) return false;
+                sig = next;
+            }
+            return true;
+        }
+
+        // characters and bool are printed by std::ostream with the base (same as Manager::print_one)
+        template <typename T>
+        bool print_as(std::ostream& os) {
+            T v;
+            if (!get(v)) return false;
+            switch (state.base) {
+                case LogBase::HEX: os << std::hex; break;
+                case LogBase::OCT: os << std::oct; break;
+                default: os << std::dec; break;
+            }
+            os << v;
+            os << std::dec;
+            return true;
+        }
+
+        template <typename T>
+        bool print_number(std::ostream& os) {
+            T v;
+            if (!get(v)) return false;
+            char buf[number::FLOAT_BUFFER_SIZE];
+            os.write(buf, (std::streamsize)number::format_number(buf, v, state.base, state.precision));
+            return true;
+        }
+
+        template <typename T>
+        bool get(T& v) {
+            return (bool)is.read(reinterpret_cast<char*>(&v), sizeof(v));
+        }
+
+        // read by blocks, so a corrupted length does not allocate more than the rest of the input
+        bool get_str(std::string& s) {
+            uint32_t n;
+            if (!get(n)) return false;
+            s.clear();
+            char buf[4096];
+            while (n) {
+                const uint32_t k = (n < sizeof(buf)) ? n : (uint32_t)sizeof(buf);
+                if (!is.read(buf, k)) return false;
+                s.append(buf, k);
+                n -= k;
+            }
+            return true;
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_BINARY_LOG_H
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef DEBUGLOG_CALL_SITE_H
+#define DEBUGLOG_CALL_SITE_H
+
+#include "Types.h"
+
+namespace arx {
+namespace debug {
+
+    // the character after the last separator in the first `n` characters of `path` (up to '\0'), or `last`
+    constexpr const char* short_filename(const char* path, const char* last, const size_t n) {
+        return (n == 0 || *path == '\0') ? last : short_filename(path + 1, (*path == '/' || *path == '\\') ? path + 1 : last, n - 1);
+    }
+
+    // scanned by chunks, so long paths do not exceed the constexpr depth limit
+    constexpr const char* short_filename(const char* path, const char* last) {
+        return has_nul(path, CONSTEXPR_CHUNK) ? short_filename(path, last, CONSTEXPR_CHUNK) : short_filename(path + CONSTEXPR_CHUNK, short_filename(path, last, CONSTEXPR_CHUNK));
+    }
+
+    // basename of the path, evaluated at compile time for string literals like __FILE__
+    constexpr const char* short_filename(const char* path) {
+        return short_filename(path, path);
+    }
+
+    // static preamble of one LOG_XXXX call site (file, line and function)
+    // created once per call site by LOG_CALLSITE() and printed with one write
+    struct CallSite {
+        const char* file;
+        const char* line;  // "L.<line>"
+        const char* func;
+#ifndef ARDUINO
+        // "<file><delim><line><delim><func><delim>:" rendered with the delimiter at the first use
+        string_t text;
+        uint32_t delim_id;
+#endif
+
+#ifdef ARDUINO
+        CallSite(const char* file, const char* line, const char* func)
+        : file(file), line(line), func(func) {}
+#else
+        CallSite(const char* file, const char* line, const char* func, const string_t& delim, const uint32_t delim_id)
+        : file(file), line(line), func(func), delim_id(delim_id) {
+            text.reserve(strlen(file) + strlen(line) + strlen(func) + 3 * delim.size() + 1);
+            text.append(file).append(delim).append(line).append(delim).append(func).append(delim).append(":");
+        }
+#endif
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_CALL_SITE_H
@@ -0,0 +1,141 @@
+#pragma once
+#ifndef DEBUGLOG_COALESCE_H
+#define DEBUGLOG_COALESCE_H
+
+#include "Types.h"
+#include "RateLimit.h"
+
+#ifndef ARDUINO
+#include <cstring>
+#endif
+
+// identical consecutive records are coalesced into "last message repeated N times" (0: disabled)
+// the summary is written before the next different record, or every interval while the record repeats
+#ifndef DEBUGLOG_DEFAULT_COALESCE_MS
+#define DEBUGLOG_DEFAULT_COALESCE_MS 0
+#endif
+
+namespace arx {
+namespace debug {
+namespace coalesce {
+
+    // key of the record for Coalescer: hash of the record without its header (the call site is in the preamble)
+    // the lower 3 bits are the level and the lower 16 bits are left for the count
+    inline uint64_t make_key(const LogLevel level, const uint64_t hash) {
+        return (((hash & 0xFFFFFFFFFFF8ull) | (uint64_t)level) << 16);
+    }
+
+#ifdef ARDUINO
+
+    // FNV-1a of the bytes printed by the arguments (the record is formatted once more only for this)
+    class Hasher : public Print {
+        uint32_t h {2166136261ul};
+
+    public:
+        using Print::write;
+        size_t write(uint8_t c) override {
+            h = (h ^ c) * 16777619ul;
+            return 1;
+        }
+
+        uint64_t hash() const {
+            return ((uint64_t)h << 16) ^ h;
+        }
+    };
+
+#else
+
+    // 8 bytes per step, which is much faster than FNV-1a for a whole record
+    inline uint64_t hash(const char* data, size_t size) {
+        static constexpr uint64_t M {0xBF58476D1CE4E5B9ull};
+        uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+        uint64_t w;
+        for (; size >= 8; data += 8, size -= 8) {
+            memcpy(&w, data, 8);
+            h = (h ^ w) * M;
+            h ^= h >> 31;
+        }
+        w = 0;
+        memcpy(&w, data, size);
+        h = (h ^ w) * M;
+        return h ^ (h >> 31);
+    }
+
+#endif
+
+    // "DebugLog : last message repeated N times\n"
+    static constexpr size_t MESSAGE_SIZE {64};
+
+    inline size_t message(char* buf, uint32_t n) {
+        static constexpr char prefix[] = "DebugLog : last message repeated ";
+        static constexpr char suffix[] = " times\n";
+        size_t len = sizeof(prefix) - 1;
+        memcpy(buf, prefix, len);
+        char d[10];
+        size_t i = 0;
+        do {
+            d[i++] = (char)('0' + n % 10);
+            n /= 10;
+        } while (n);
+        while (i) buf[len++] = d[--i];
+        memcpy(buf + len, suffix, sizeof(suffix) - 1);
+        return len + sizeof(suffix) - 1;
+    }
+
+}  // namespace coalesce
+
+    // repeats of the last record of one output (std::cout, the file or a sink)
+    // updated by one CAS without lock, so each output is coalesced independently
+    class Coalescer {
+        static constexpr uint64_t COUNT_MASK {0xFFFF};
+        RelaxedAtomic<uint64_t> state {0};     // key (upper 48 bits) and suppressed repeats (lower 16 bits)
+        RelaxedAtomic<uint32_t> first_ms {0};  // time of the first suppressed repeat
+
+    public:
+        struct Result {
+            bool b_write;         // false if the record is suppressed
+            uint32_t n_repeated;  // "last message repeated N times" is written before the record (if not 0)
+            LogLevel level;       // level of the repeated record
+        };
+
+        Result check(const uint64_t key, const uint32_t interval_ms) {
+            uint64_t s = state.load();
+            uint32_t now = 0;
+            bool b_now = false;
+            while (true) {
+                const uint32_t n = (uint32_t)(s & COUNT_MASK);
+                const LogLevel level = (LogLevel)((s >> 16) & 0x7);
+                if ((s & ~COUNT_MASK) != key) {
+                    if (state.compare_exchange(s, key)) return Result {true, n, level};
+                    continue;
+                }
+                if (!b_now) {
+                    now = now_ms();
+                    b_now = true;
+                }
+                // the repeats so far and this record are reported at once when the interval has passed
+                const bool b_due = (n + 1 == COUNT_MASK) || (n != 0 && (uint32_t)(now - first_ms.load()) >= interval_ms);
+                if (state.compare_exchange(s, b_due ? key : s + 1)) {
+                    if (n == 0) first_ms.store(now);
+                    return Result {false, b_due ? n + 1 : 0, level};
+                }
+            }
+        }
+
+        // repeats not reported yet if the interval has passed since the first of them (or `b_force`)
+        // for the output which does not get a record to report them before
+        Result take(const uint32_t interval_ms, const bool b_force) {
+            uint64_t s = state.load();
+            while (s & COUNT_MASK) {
+                if (!b_force && (uint32_t)(now_ms() - first_ms.load()) < interval_ms) break;
+                if (state.compare_exchange(s, s & ~COUNT_MASK))
+                    return Result {false, (uint32_t)(s & COUNT_MASK), (LogLevel)((s >> 16) & 0x7)};
+            }
+            return Result {false, 0, LogLevel::LVL_NONE};
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_COALESCE_H
@@ -0,0 +1,327 @@
+#pragma once
+#ifndef DEBUGLOG_COMPRESS_H
+#define DEBUGLOG_COMPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Compressed log format (little endian)
+//
+// file  : frame*
+// frame : "DZ", u8 type, u32 raw size, u32 stored size, u32 checksum of raw data, stored data
+// type  : 0 (stored as is) | 1 (LZ4 block format)
+//
+// every frame is compressed without the history of the previous frames,
+// so a truncated file is decoded up to the last whole frame and a corrupted frame is skipped by the magic
+
+// bits of the hash table of the compressor (uint16_t per entry)
+#ifndef DEBUGLOG_COMPRESS_HASH_BITS
+#if defined(__AVR__)
+#define DEBUGLOG_COMPRESS_HASH_BITS 6
+#elif defined(ARDUINO)
+#define DEBUGLOG_COMPRESS_HASH_BITS 10
+#else
+#define DEBUGLOG_COMPRESS_HASH_BITS 12
+#endif
+#endif
+
+namespace arx {
+namespace debug {
+namespace compress {
+
+    static constexpr size_t FRAME_HEADER_SIZE {2 + 1 + 4 + 4 + 4};
+    static constexpr size_t MAX_BLOCK_SIZE {65535};  // positions in the hash table are uint16_t
+    static constexpr size_t HASH_SIZE {1u << DEBUGLOG_COMPRESS_HASH_BITS};
+
+    enum FrameType : uint8_t {
+        STORED = 0,
+        LZ4 = 1,
+    };
+
+    inline void put_u32(uint8_t* p, const uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    inline uint32_t get_u32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // FNV-1a over little endian 32-bit words (and the last bytes)
+    inline uint32_t checksum(const uint8_t* data, const size_t size) {
+        uint32_t h = 2166136261u;
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) h = (h ^ get_u32(data + i)) * 16777619u;
+        for (; i < size; ++i) h = (h ^ data[i]) * 16777619u;
+        return h;
+    }
+
+    inline uint32_t hash4(const uint8_t* p) {
+        return (get_u32(p) * 2654435761u) >> (32 - DEBUGLOG_COMPRESS_HASH_BITS);
+    }
+
+    // compresses `size` (<= MAX_BLOCK_SIZE) bytes into the LZ4 block format
+    // returns 0 if the result does not fit in `cap` bytes
+    inline size_t compress_block(const uint8_t* src, const size_t size, uint8_t* dst, const size_t cap, uint16_t* table) {
+        static constexpr size_t MIN_MATCH {4};
+        static constexpr size_t LAST_LITERALS {5};  // the block ends with literals
+        static constexpr size_t MF_LIMIT {12};      // no match starts in the last bytes
+
+        uint8_t* op = dst;
+        uint8_t* const oend = dst + cap;
+        size_t anchor = 0;
+        size_t ip = 0;
+
+        if (size > MF_LIMIT) {
+            memset(table, 0, HASH_SIZE * sizeof(uint16_t));
+            const size_t match_limit = size - LAST_LITERALS;
+            ip = 1;
+            while (ip + MF_LIMIT <= size) {
+                const uint32_t h = hash4(src + ip);
+                const size_t ref = table[h];
+                table[h] = (uint16_t)ip;
+                if (ref >= ip || memcmp(src + ref, src + ip, MIN_MATCH) != 0) {
+                    ip += 1 + ((ip - anchor) >> 6);  // skip faster in incompressible data
+                    continue;
+                }
+                size_t start = ip;
+                size_t ref_start = ref;
+                while (start > anchor && ref_start > 0 && src[start - 1] == src[ref_start - 1]) {
+                    --start;
+                    --ref_start;
+                }
+                size_t end = ip + MIN_MATCH;
+                size_t ref_end = ref + MIN_MATCH;
+                while (end < match_limit && src[end] == src[ref_end]) {
+                    ++end;
+                    ++ref_end;
+                }
+
+                // token, literal length, literals, offset, match length
+                const size_t n_literals = start - anchor;
+                const size_t n_match = end - start - MIN_MATCH;
+                if (op + 1 + n_literals / 255 + 1 + n_literals + 2 + n_match / 255 + 1 > oend) return 0;
+                uint8_t* token = op++;
+                *token = (uint8_t)((n_literals >= 15 ? 15 : n_literals) << 4);
+                if (n_literals >= 15) {
+                    size_t n = n_literals - 15;
+                    for (; n >= 255; n -= 255) *op++ = 255;
+                    *op++ = (uint8_t)n;
+                }
+                memcpy(op, src + anchor, n_literals);
+                op += n_literals;
+                const size_t offset = start - ref_start;
+                *op++ = (uint8_t)offset;
+                *op++ = (uint8_t)(offset >> 8);
+                *token |= (uint8_t)(n_match >= 15 ? 15 : n_match);
+                if (n_match >= 15) {
+                    size_t n = n_match - 15;
+                    for (; n >= 255; n -= 255) *op++ = 255;
+                    *op++ = (uint8_t)n;
+                }
+
+                anchor = ip = end;
+                if (ip + MF_LIMIT <= size) table[hash4(src + ip - 2)] = (uint16_t)(ip - 2);
+            }
+        }
+
+        // last literals
+        const size_t n_literals = size - anchor;
+        if (op + 1 + n_literals / 255 + 1 + n_literals > oend) return 0;
+        *op++ = (uint8_t)((n_literals >= 15 ? 15 : n_literals) << 4);
+        if (n_literals >= 15) {
+            size_t n = n_literals - 15;
+            for (; n >= 255; n -= 255) *op++ = 255;
+            *op++ = (uint8_t)n;
+        }
+        memcpy(op, src + anchor, n_literals);
+        op += n_literals;
+        return (size_t)(op - dst);
+    }
+
+    // returns false if the block is corrupted or is not `raw_size` bytes
+    inline bool decompress_block(const uint8_t* src, const size_t size, uint8_t* dst, const size_t raw_size) {
+        const uint8_t* ip = src;
+        const uint8_t* const iend = src + size;
+        uint8_t* op = dst;
+        uint8_t* const oend = dst + raw_size;
+        while (ip < iend) {
+            const uint8_t token = *ip++;
+            size_t n_literals = token >> 4;
+            if (n_literals == 15) {
+                uint8_t b;
+                do {
+                    if (ip == iend) return false;
+                    b = *ip++;
+                    n_literals += b;
+                } while (b == 255);
+            }
+            if ((size_t)(iend - ip) < n_literals || (size_t)(oend - op) < n_literals) return false;
+            memcpy(op, ip, n_literals);
+            ip += n_literals;
+            op += n_literals;
+            if (ip == iend) break;  // last literals
+
+            if (iend - ip < 2) return false;
+            const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+            ip += 2;
+            size_t n_match = (token & 15) + 4;
+            if ((token & 15) == 15) {
+                uint8_t b;
+                do {
+                    if (ip == iend) return false;
+                    b = *ip++;
+                    n_match += b;
+                } while (b == 255);
+            }
+            if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(oend - op) < n_match) return false;
+            const uint8_t* ref = op - offset;
+            if (offset >= n_match)
+                memcpy(op, ref, n_match);
+            else
+                for (size_t i = 0; i < n_match; ++i) op[i] = ref[i];  // repeats the last `offset` bytes
+            op += n_match;
+        }
+        return op == oend;
+    }
+
+    // writes one frame of `size` (<= MAX_BLOCK_SIZE) bytes into `frame` (FRAME_HEADER_SIZE + size bytes)
+    // the data is stored as is if it is not compressible
+    inline size_t write_frame(const uint8_t* data, const size_t size, uint8_t* frame, uint16_t* table) {
+        size_t n = compress_block(data, size, frame + FRAME_HEADER_SIZE, size, table);
+        const uint8_t type = n ? LZ4 : STORED;
+        if (!n && size) {
+            memcpy(frame + FRAME_HEADER_SIZE, data, size);
+            n = size;
+        }
+        frame[0] = 'D';
+        frame[1] = 'Z';
+        frame[2] = type;
+        put_u32(frame + 3, (uint32_t)size);
+        put_u32(frame + 7, (uint32_t)n);
+        put_u32(frame + 11, checksum(data, size));
+        return FRAME_HEADER_SIZE + n;
+    }
+
+    // header of one frame
+    struct Frame {
+        uint8_t type;
+        uint32_t raw_size;
+        uint32_t stored_size;
+        uint32_t check;
+
+        // false if `p` is not the header of a frame
+        bool read(const uint8_t* p) {
+            if (p[0] != 'D' || p[1] != 'Z' || p[2] > LZ4) return false;
+            type = p[2];
+            raw_size = get_u32(p + 3);
+            stored_size = get_u32(p + 7);
+            check = get_u32(p + 11);
+            return raw_size <= MAX_BLOCK_SIZE && stored_size <= MAX_BLOCK_SIZE;
+        }
+
+        // decodes the stored data into `dst` (raw_size bytes)
+        bool decode(const uint8_t* data, uint8_t* dst) const {
+            if (type == STORED) {
+                if (stored_size != raw_size) return false;
+                memcpy(dst, data, raw_size);
+            } else if (!decompress_block(data, stored_size, dst, raw_size)) {
+                return false;
+            }
+            return checksum(dst, raw_size) == check;
+        }
+    };
+
+}  // namespace compress
+}  // namespace debug
+}  // namespace arx
+
+#ifndef ARDUINO
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Sink.h"
+
+// records are compressed into one frame when this size is buffered
+#ifndef DEBUGLOG_COMPRESS_BLOCK_SIZE
+#define DEBUGLOG_COMPRESS_BLOCK_SIZE (32 * 1024)
+#endif
+
+namespace arx {
+namespace debug {
+
+    // compresses records into frames and writes them to another sink (e.g. FileSink)
+    // decode the output by tools/log_decompressor
+    class CompressedSink : public Sink {
+        std::shared_ptr<Sink> sink;
+        std::mutex mtx;
+        size_t block_size;
+        std::vector<uint8_t> buf;
+        std::vector<uint8_t> frame;
+        std::vector<uint16_t> table;
+        bool b_closed {false};
+
+    public:
+        explicit CompressedSink(const std::shared_ptr<Sink>& sink, const size_t block_size = DEBUGLOG_COMPRESS_BLOCK_SIZE)
+        : sink(sink)
+        , block_size((block_size == 0 || block_size > compress::MAX_BLOCK_SIZE) ? compress::MAX_BLOCK_SIZE : block_size)
+        , frame(compress::FRAME_HEADER_SIZE + this->block_size)
+        , table(compress::HASH_SIZE) {
+            buf.reserve(this->block_size);
+        }
+
+        ~CompressedSink() {
+            flush();
+        }
+
+        void write(const char* data, size_t size) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            while (size) {
+                size_t n = block_size - buf.size();
+                if (n > size) n = size;
+                buf.insert(buf.end(), data, data + n);
+                data += n;
+                size -= n;
+                if (buf.size() == block_size) write_frame();
+            }
+        }
+
+        // the partial block is written as a smaller frame
+        void flush() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            write_frame();
+            if (sink) sink->flush();
+        }
+
+        // the partial block is written and the inner sink is closed
+        void close() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            b_closed = true;
+            write_frame();
+            if (sink) sink->close();
+        }
+
+    private:
+        void write_frame() {
+            if (buf.empty() || !sink) return;
+            const size_t n = compress::write_frame(buf.data(), buf.size(), frame.data(), table.data());
+            sink->write(reinterpret_cast<const char*>(frame.data()), n);
+            buf.clear();
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_COMPRESS_H
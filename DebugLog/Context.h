@@ -0,0 +1,67 @@
+#pragma once
+#ifndef DEBUGLOG_CONTEXT_H
+#define DEBUGLOG_CONTEXT_H
+
+#include "Types.h"
+
+// bytes of "key=value " of all LOG_CONTEXT() scopes of one thread (pairs which do not fit are dropped)
+#ifndef DEBUGLOG_CONTEXT_SIZE
+#if defined(__AVR__)
+#define DEBUGLOG_CONTEXT_SIZE 32
+#elif defined(ARDUINO)
+#define DEBUGLOG_CONTEXT_SIZE 64
+#else
+#define DEBUGLOG_CONTEXT_SIZE 128
+#endif
+#endif
+
+namespace arx {
+namespace debug {
+
+    // "key=value " of the LOG_CONTEXT() scopes of the current thread, rendered when each scope begins
+    // and written after the level tag and the timestamp of every record as is
+    struct Context {
+        char data[DEBUGLOG_CONTEXT_SIZE];
+        size_t size;
+
+        // zero-initialized (no guard and no heap on the log path)
+        static Context& get() {
+#ifdef ARDUINO
+            static Context c;
+#else
+            static thread_local Context c;
+#endif
+            return c;
+        }
+    };
+
+#ifdef ARDUINO
+    // renders the value of LOG_CONTEXT() into the free space of the context (fails if it does not fit)
+    class ContextWriter : public Print {
+        char* buf;
+        size_t cap;
+        size_t n {0};
+        bool b_overflow {false};
+
+    public:
+        ContextWriter(char* buf, const size_t cap)
+        : buf(buf), cap(cap) {}
+
+        using Print::write;
+        size_t write(uint8_t c) override {
+            if (n == cap) {
+                b_overflow = true;
+                return 0;
+            }
+            buf[n++] = (char)c;
+            return 1;
+        }
+
+        size_t size() const { return b_overflow ? 0 : n; }
+    };
+#endif
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_CONTEXT_H
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef DEBUGLOG_DROP_COUNTER_H
+#define DEBUGLOG_DROP_COUNTER_H
+
+#include "Types.h"
+
+namespace arx {
+namespace debug {
+
+    // number of records discarded by OverflowPolicy per level (LVL_NONE: PRINT / PRINTLN)
+    class DropCounter {
+    public:
+        static constexpr size_t N_LEVELS {(size_t)LogLevel::LVL_TRACE + 1};
+
+    private:
+        RelaxedAtomic<uint32_t> n_dropped[N_LEVELS] {{0}, {0}, {0}, {0}, {0}, {0}};
+        uint32_t n_reported[N_LEVELS] {};  // touched only by the reporter
+
+    public:
+        void add(const LogLevel level) {
+            n_dropped[(size_t)level].fetch_add(1);
+        }
+
+        uint32_t count(const LogLevel level) const {
+            return n_dropped[(size_t)level].load();
+        }
+
+        uint32_t count() const {
+            uint32_t n = 0;
+            for (size_t i = 0; i < N_LEVELS; ++i) n += n_dropped[i].load();
+            return n;
+        }
+
+        // stores the records dropped since the last call to `n` and returns their sum
+        // must be called from one thread (or context) only
+        uint32_t take_unreported(uint32_t (&n)[N_LEVELS]) {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < N_LEVELS; ++i) {
+                const uint32_t total = n_dropped[i].load();
+                n[i] = total - n_reported[i];
+                n_reported[i] = total;
+                sum += n[i];
+            }
+            return sum;
+        }
+
+        // not thread safe: called while nothing is dropped (e.g. before the writer restarts)
+        void reset() {
+            for (size_t i = 0; i < N_LEVELS; ++i) {
+                n_dropped[i].store(0);
+                n_reported[i] = 0;
+            }
+        }
+
+        static const char* label(const size_t i) {
+            switch ((LogLevel)i) {
+                case LogLevel::LVL_ERROR: return "ERROR";
+                case LogLevel::LVL_WARN: return "WARN";
+                case LogLevel::LVL_INFO: return "INFO";
+                case LogLevel::LVL_DEBUG: return "DEBUG";
+                case LogLevel::LVL_TRACE: return "TRACE";
+                default: return "PRINT";
+            }
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_DROP_COUNTER_H
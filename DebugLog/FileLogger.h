@@ -3,42 +3,136 @@
 #define DEBUGLOG_FILE_LOGGER_H
 
 #include "Types.h"
+#include "Compress.h"
 
 namespace arx {
 namespace debug {
 
 #ifdef ARDUINO
 
-    struct FileLogger {
+#ifndef DEBUGLOG_FILE_BUFFER_SIZE
+#ifdef __AVR__
+#define DEBUGLOG_FILE_BUFFER_SIZE 64
+#else
+#define DEBUGLOG_FILE_BUFFER_SIZE 512  // one sector of SD cards
+#endif
+#endif
+
+#ifndef DEBUGLOG_FILE_FLUSH_BYTES
+#define DEBUGLOG_FILE_FLUSH_BYTES 512
+#endif
+#ifndef DEBUGLOG_FILE_FLUSH_RECORDS
+#define DEBUGLOG_FILE_FLUSH_RECORDS 16
+#endif
+#ifndef DEBUGLOG_FILE_FLUSH_INTERVAL_MS
+#define DEBUGLOG_FILE_FLUSH_INTERVAL_MS 1000
+#endif
+
+    // auto save flushes the file when one of the thresholds is reached (0 disables the threshold)
+    // LVL_ERROR and assertions are always flushed immediately
+    struct FlushPolicy {
+        size_t bytes;
+        size_t records;
+        uint32_t interval_ms;
+
+        FlushPolicy(const size_t bytes = DEBUGLOG_FILE_FLUSH_BYTES, const size_t records = DEBUGLOG_FILE_FLUSH_RECORDS, const uint32_t interval_ms = DEBUGLOG_FILE_FLUSH_INTERVAL_MS)
+        : bytes(bytes), records(records), interval_ms(interval_ms) {}
+    };
+
+    // logs are formatted into the block buffer by Print and only full blocks are written to the file
+    // every token is still one virtual Print::write() into the buffer, and only write_block() / sync() of the file type
+    // are called per block
+    // with DEBUGLOG_ENABLE_FILE_COMPRESSION, each block is written as one compressed frame (see Compress.h)
+    class FileLogger : public Print {
+        uint8_t buf[DEBUGLOG_FILE_BUFFER_SIZE];
+        size_t n_buf {0};
+#ifdef DEBUGLOG_ENABLE_FILE_COMPRESSION
+        static_assert(DEBUGLOG_FILE_BUFFER_SIZE <= compress::MAX_BLOCK_SIZE, "DEBUGLOG_FILE_BUFFER_SIZE is too large for one frame");
+        uint8_t frame[compress::FRAME_HEADER_SIZE + DEBUGLOG_FILE_BUFFER_SIZE];
+        uint16_t table[compress::HASH_SIZE];
+#endif
+
+    public:
+        FileLogger()
+        : last_flush_ms(millis()) {}
         virtual ~FileLogger() {}
 
         virtual bool is_open() = 0;
-        virtual void flush() = 0;
-
-        virtual size_t print(const __FlashStringHelper*) = 0;
-        virtual size_t print(const String&) = 0;
-        virtual size_t print(const char[]) = 0;
-        virtual size_t print(const char) = 0;
-        virtual size_t print(const unsigned char, const int = DEC) = 0;
-        virtual size_t print(const int, const int = DEC) = 0;
-        virtual size_t print(const unsigned int, const int = DEC) = 0;
-        virtual size_t print(const long, const int = DEC) = 0;
-        virtual size_t print(const unsigned long, const int = DEC) = 0;
-        virtual size_t print(const double, const int = 2) = 0;
-        virtual size_t print(const Printable&) = 0;
-
-        virtual size_t println(const __FlashStringHelper*) = 0;
-        virtual size_t println(const String&) = 0;
-        virtual size_t println(const char[]) = 0;
-        virtual size_t println(const char) = 0;
-        virtual size_t println(const unsigned char, const int = DEC) = 0;
-        virtual size_t println(const int, const int = DEC) = 0;
-        virtual size_t println(const unsigned int, const int = DEC) = 0;
-        virtual size_t println(const long, const int = DEC) = 0;
-        virtual size_t println(const unsigned long, const int = DEC) = 0;
-        virtual size_t println(const double, const int = 2) = 0;
-        virtual size_t println(const Printable&) = 0;
-        virtual size_t println(void) = 0;
+
+        using Print::write;
+
+        size_t write(uint8_t c) override {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t* data, size_t size) override {
+            n_bytes += size;
+            const size_t n = size;
+            while (size) {
+                if (n_buf == 0 && size >= DEBUGLOG_FILE_BUFFER_SIZE) {
+                    // bypass the buffer for whole blocks
+                    const size_t n_blocks = size - size % DEBUGLOG_FILE_BUFFER_SIZE;
+                    put_blocks(data, n_blocks);
+                    data += n_blocks;
+                    size -= n_blocks;
+                    continue;
+                }
+                size_t m = DEBUGLOG_FILE_BUFFER_SIZE - n_buf;
+                if (m > size) m = size;
+                memcpy(buf + n_buf, data, m);
+                n_buf += m;
+                data += m;
+                size -= m;
+                if (n_buf == DEBUGLOG_FILE_BUFFER_SIZE) drain();
+            }
+            return n;
+        }
+
+        // write the buffered logs and flush the file
+        void flush() {
+            drain();
+            sync();
+            n_bytes = 0;
+            n_records = 0;
+            last_flush_ms = millis();
+        }
+
+        // called at the end of each record in auto save mode
+        void commit(const FlushPolicy& policy, const bool b_force) {
+            ++n_records;
+            if (b_force
+                || (policy.bytes && n_bytes >= policy.bytes)
+                || (policy.records && n_records >= policy.records)
+                || (policy.interval_ms && (uint32_t)(millis() - last_flush_ms) >= policy.interval_ms))
+                flush();
+        }
+
+    protected:
+        virtual void write_block(const uint8_t* data, const size_t size) = 0;
+        virtual void sync() = 0;
+
+        // write the partial block to the file
+        void drain() {
+            if (n_buf == 0) return;
+            put_blocks(buf, n_buf);
+            n_buf = 0;
+        }
+
+        void put_blocks(const uint8_t* data, const size_t size) {
+#ifdef DEBUGLOG_ENABLE_FILE_COMPRESSION
+            for (size_t i = 0; i < size; i += DEBUGLOG_FILE_BUFFER_SIZE) {
+                const size_t n = (size - i < DEBUGLOG_FILE_BUFFER_SIZE) ? size - i : DEBUGLOG_FILE_BUFFER_SIZE;
+                write_block(frame, compress::write_frame(data + i, n, frame, table));
+            }
+#else
+            write_block(data, size);
+#endif
+        }
+
+    private:
+        size_t n_bytes {0};    // written since the last flush
+        size_t n_records {0};  // committed since the last flush
+        uint32_t last_flush_ms;
     };
 
     template <typename FsType, typename FileType>
@@ -55,36 +149,17 @@ namespace debug {
         }
 
         virtual ~FsFileLogger() {
-            if (file) file.close();
+            if (file) {
+                drain();
+                file.close();
+            }
         }
 
         virtual bool is_open() override { return file ? true : false; }  // bool file() isn't const...
-        virtual void flush() override { file.flush(); }
-
-        virtual size_t print(const __FlashStringHelper* x) override { return file.print(x); }
-        virtual size_t print(const String& x) override { return file.print(x); }
-        virtual size_t print(const char x[]) override { return file.print(x); }
-        virtual size_t print(const char x) override { return file.print(x); }
-        virtual size_t print(const unsigned char x, const int b = DEC) override { return file.print(x, b); }
-        virtual size_t print(const int x, const int b = DEC) override { return file.print(x, b); }
-        virtual size_t print(const unsigned int x, const int b = DEC) override { return file.print(x, b); }
-        virtual size_t print(const long x, const int b = DEC) override { return file.print(x, b); }
-        virtual size_t print(const unsigned long x, const int b = DEC) override { return file.print(x, b); }
-        virtual size_t print(const double x, const int b = 2) override { return file.print(x, b); }
-        virtual size_t print(const Printable& x) override { return file.print(x); }
-
-        virtual size_t println(const __FlashStringHelper* x) override { return file.println(x); }
-        virtual size_t println(const String& x) override { return file.println(x); }
-        virtual size_t println(const char x[]) override { return file.println(x); }
-        virtual size_t println(const char x) override { return file.println(x); }
-        virtual size_t println(const unsigned char x, const int b = DEC) override { return file.println(x, b); }
-        virtual size_t println(const int x, const int b = DEC) override { return file.println(x, b); }
-        virtual size_t println(const unsigned int x, const int b = DEC) override { return file.println(x, b); }
-        virtual size_t println(const long x, const int b = DEC) override { return file.println(x, b); }
-        virtual size_t println(const unsigned long x, const int b = DEC) override { return file.println(x, b); }
-        virtual size_t println(const double x, const int b = 2) override { return file.println(x, b); }
-        virtual size_t println(const Printable& x) override { return file.println(x); }
-        virtual size_t println(void) override { return file.println(); }
+
+    protected:
+        virtual void write_block(const uint8_t* data, const size_t size) override { file.write(data, size); }
+        virtual void sync() override { file.flush(); }
     };
 
 #endif  // ARDUINO
@@ -0,0 +1,417 @@
+#pragma once
+#ifndef DEBUGLOG_FLIGHT_RECORDER_H
+#define DEBUGLOG_FLIGHT_RECORDER_H
+
+#ifndef ARDUINO
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <unistd.h>
+#define DEBUGLOG_HAS_CRASH_HANDLER
+#endif
+#endif
+
+#include "Types.h"
+
+// the last N records down to the recorder level (all levels by default) are kept in memory
+// and dumped on assertion failure or LOG_DUMP_RECORDER()
+// records longer than the record size are truncated with "..." (0 records: disabled)
+#ifndef DEBUGLOG_FLIGHT_RECORDER_RECORDS
+#ifdef ARDUINO
+#define DEBUGLOG_FLIGHT_RECORDER_RECORDS 0
+#else
+#define DEBUGLOG_FLIGHT_RECORDER_RECORDS 256
+#endif
+#endif
+#ifndef DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE
+#ifdef ARDUINO
+#define DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE 64
+#else
+#define DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE 256
+#endif
+#endif
+// LOG_XXXX down to this level are kept even if the outputs filter them out (default: TRACE)
+// DEBUGLOG_DEFAULT_RECORDER_FOLLOWS_OUTPUTS (or LOG_RECORDER_FOLLOW_OUTPUTS() at runtime) keeps only the records
+// written to any output instead, so LOG_XXXX filtered out by the outputs are not evaluated for the recorder
+#if DEBUGLOG_FLIGHT_RECORDER_RECORDS == 0 || defined(DEBUGLOG_DEFAULT_RECORDER_LEVEL_NONE)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_NONE
+#elif defined(DEBUGLOG_DEFAULT_RECORDER_LEVEL_ERROR)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_ERROR
+#elif defined(DEBUGLOG_DEFAULT_RECORDER_LEVEL_WARN)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_WARN
+#elif defined(DEBUGLOG_DEFAULT_RECORDER_LEVEL_INFO)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_INFO
+#elif defined(DEBUGLOG_DEFAULT_RECORDER_LEVEL_DEBUG)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_DEBUG
+#elif defined(DEBUGLOG_DEFAULT_RECORDER_FOLLOWS_OUTPUTS)
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_NONE
+#else
+#define DEBUGLOG_DEFAULT_RECORDER_LEVEL LogLevel::LVL_TRACE
+#endif
+#if DEBUGLOG_FLIGHT_RECORDER_RECORDS > 0 && defined(DEBUGLOG_DEFAULT_RECORDER_FOLLOWS_OUTPUTS)
+#define DEBUGLOG_DEFAULT_RECORDER_FOLLOWS true
+#else
+#define DEBUGLOG_DEFAULT_RECORDER_FOLLOWS false
+#endif
+
+namespace arx {
+namespace debug {
+
+#if DEBUGLOG_FLIGHT_RECORDER_RECORDS > 0
+#ifdef ARDUINO
+
+    // ring of the last records which is written as Print by LOG_XXXX
+    class FlightRecorder : public Print {
+        static constexpr size_t N {DEBUGLOG_FLIGHT_RECORDER_RECORDS};
+        static constexpr size_t SIZE {DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE};
+        static_assert(SIZE >= 8 && SIZE <= 255, "DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE must be 8 - 255 on Arduino");
+
+        struct Slot {
+            uint8_t size;
+            char data[SIZE];
+        };
+
+        Slot slots[N];
+        size_t head {0};
+        size_t count {0};
+        bool b_truncated {false};
+        RelaxedAtomic<LogLevel> lvl {DEBUGLOG_DEFAULT_RECORDER_LEVEL};
+        RelaxedAtomic<bool> b_follow {DEBUGLOG_DEFAULT_RECORDER_FOLLOWS};
+
+    public:
+        LogLevel level() const { return lvl.load(); }
+        void level(const LogLevel l) {
+            lvl.store(l);
+            b_follow.store(false);
+        }
+
+        // only the records written to any output are kept
+        bool follows_outputs() const { return b_follow.load(); }
+        void follow_outputs() {
+            lvl.store(LogLevel::LVL_NONE);
+            b_follow.store(true);
+        }
+
+        void begin_record() {
+            slots[head].size = 0;
+            b_truncated = false;
+        }
+
+        void end_record() {
+            Slot& s = slots[head];
+            if (b_truncated) memcpy(s.data + SIZE - 4, "...\n", 4);
+            head = (head + 1) % N;
+            if (count < N) ++count;
+        }
+
+        using Print::write;
+        size_t write(uint8_t c) override {
+            Slot& s = slots[head];
+            if (s.size < SIZE)
+                s.data[s.size++] = (char)c;
+            else
+                b_truncated = true;
+            return 1;
+        }
+
+        // records since the last clear() (oldest first)
+        void dump(Print* p) const {
+            if (count == 0) return;
+            p->print(F("[WARN] DebugLog : flight recorder dump ("));
+            p->print((unsigned long)count);
+            p->println(F(" records)"));
+            for (size_t i = (head + N - count) % N, n = 0; n < count; i = (i + 1) % N, ++n)
+                p->write((const uint8_t*)slots[i].data, slots[i].size);
+            p->println(F("[WARN] DebugLog : end of flight recorder dump"));
+        }
+
+        void clear() {
+            count = 0;
+        }
+    };
+
+#else
+
+    // written instead of the raw arguments of a compact record in the signal handler
+    static constexpr char RECORDER_RAW_NOTE[] = "(arguments are not formatted in the signal handler)\n";
+
+    // prints the raw arguments of a compact record as LOG_XXXX would have printed them (see Manager::record_raw())
+    using RecordRender = void (*)(const FormatState& f, const char* args, const size_t size, std::ostream* s);
+
+    // ring of the last records in fixed-size slots
+    // a record takes one slot by an atomic counter and the slot is locked only while it is copied,
+    // so logging threads do not wait for each other unless the ring wraps around during the copy
+    class FlightRecorder {
+        static constexpr size_t N {DEBUGLOG_FLIGHT_RECORDER_RECORDS};
+        static constexpr size_t SIZE {DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE};
+        static_assert(SIZE >= 8 && SIZE <= 65535, "DEBUGLOG_FLIGHT_RECORDER_RECORD_SIZE must be 8 - 65535");
+
+        struct Slot {
+            std::atomic<bool> busy {false};
+            uint64_t index {UINT64_MAX};
+            LogLevel level {LogLevel::LVL_NONE};
+            uint16_t header_size {0};
+            uint16_t time_size {0};
+            uint16_t text_size {0};  // compact record: the text before the raw arguments
+            uint16_t size {0};
+            RecordRender render {nullptr};  // nullptr: text record
+            FormatState format;
+            char data[SIZE];
+        };
+
+        Slot slots[N];
+        RelaxedAtomic<uint64_t> next {0};
+        RelaxedAtomic<uint64_t> dumped {0};
+        RelaxedAtomic<LogLevel> lvl {DEBUGLOG_DEFAULT_RECORDER_LEVEL};
+        RelaxedAtomic<bool> b_follow {DEBUGLOG_DEFAULT_RECORDER_FOLLOWS};
+
+    public:
+        // records [begin, end) taken by dump
+        struct Range {
+            uint64_t begin;
+            uint64_t end;
+            uint64_t size() const { return end - begin; }
+        };
+
+        LogLevel level() const { return lvl.load(); }
+        void level(const LogLevel l) {
+            lvl.store(l);
+            b_follow.store(false);
+        }
+
+        // only the records written to any output are kept
+        bool follows_outputs() const { return b_follow.load(); }
+        void follow_outputs() {
+            lvl.store(LogLevel::LVL_NONE);
+            b_follow.store(true);
+        }
+
+        // `data` is the text record which has `header_size` bytes of header (see SinkRegistry::write())
+        void write(const LogLevel level, const char* data, const size_t size, const size_t header_size, const size_t time_size) {
+            const uint64_t i = next.fetch_add(1);
+            Slot& s = slots[i % N];
+            while (s.busy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+            if (s.index == UINT64_MAX || s.index < i) {
+                const size_t n = (size < SIZE) ? size : SIZE;
+                memcpy(s.data, data, n);
+                if (n < size) memcpy(s.data + SIZE - 4, "...\n", 4);
+                s.index = i;
+                s.level = level;
+                s.size = (uint16_t)n;
+                s.header_size = (uint16_t)((header_size < n) ? header_size : n);
+                s.time_size = (uint16_t)((time_size < s.header_size) ? time_size : 0);
+                s.text_size = s.size;
+                s.render = nullptr;
+            }
+            s.busy.store(false, std::memory_order_release);
+        }
+
+        // compact record: `text_size` bytes of text (header and context) followed by the raw arguments
+        // which are printed by `render` with the format state `f` when the record is dumped
+        // returns false if the record does not fit in a slot (raw arguments cannot be cut)
+        bool write(const LogLevel level, const char* data, const size_t size, const size_t header_size, const size_t time_size, const size_t text_size, const RecordRender render, const FormatState& f) {
+            if (size > SIZE) return false;
+            const uint64_t i = next.fetch_add(1);
+            Slot& s = slots[i % N];
+            while (s.busy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+            if (s.index == UINT64_MAX || s.index < i) {
+                memcpy(s.data, data, size);
+                s.index = i;
+                s.level = level;
+                s.size = (uint16_t)size;
+                s.header_size = (uint16_t)header_size;
+                s.time_size = (uint16_t)time_size;
+                s.text_size = (uint16_t)text_size;
+                s.render = render;
+                s.format = f;
+            }
+            s.busy.store(false, std::memory_order_release);
+            return true;
+        }
+
+        // records which are still in the ring and not dumped yet (next take() starts after them)
+        Range take() {
+            const uint64_t end = next.load();
+            uint64_t begin = dumped.load();
+            do {
+                if (begin >= end) return Range {end, end};
+            } while (!dumped.compare_exchange(begin, end));
+            if (end - begin > N) begin = end - N;
+            return Range {begin, end};
+        }
+
+        // calls f(level, data, size, header_size, time_size) for each record in the range (oldest first)
+        // records overwritten meanwhile are skipped
+        // `b_wait` is false in a signal handler: a slot locked by the interrupted thread is skipped instead of waiting,
+        // and the raw arguments of compact records are not formatted
+        template <typename F>
+        void for_each(const Range& r, F&& f, const bool b_wait = true) {
+            char buf[SIZE + sizeof(RECORDER_RAW_NOTE)];
+            for (uint64_t i = r.begin; i < r.end; ++i) {
+                Slot& s = slots[i % N];
+                bool b_locked = !s.busy.exchange(true, std::memory_order_acquire);
+                while (!b_locked && b_wait) {
+                    std::this_thread::yield();
+                    b_locked = !s.busy.exchange(true, std::memory_order_acquire);
+                }
+                if (!b_locked) continue;
+                const bool b_valid = s.index == i;
+                const LogLevel level = s.level;
+                const size_t size = s.size;
+                const size_t header_size = s.header_size;
+                const size_t time_size = s.time_size;
+                const size_t text_size = s.text_size;
+                const RecordRender render = s.render;
+                const FormatState format = s.format;
+                if (b_valid) memcpy(buf, s.data, size);
+                s.busy.store(false, std::memory_order_release);
+                if (!b_valid) continue;
+                if (!render) {
+                    f(level, (const char*)buf, size, header_size, time_size);
+                } else if (!b_wait) {
+                    memcpy(buf + text_size, RECORDER_RAW_NOTE, sizeof(RECORDER_RAW_NOTE) - 1);
+                    f(level, (const char*)buf, text_size + sizeof(RECORDER_RAW_NOTE) - 1, header_size, time_size);
+                } else {
+                    std::ostringstream os;
+                    os.write(buf, (std::streamsize)text_size);
+                    render(format, buf + text_size, size - text_size, &os);
+                    const std::string str = os.str();
+                    f(level, str.data(), str.size(), header_size, time_size);
+                }
+            }
+        }
+    };
+
+#endif  // ARDUINO
+#else   // DEBUGLOG_FLIGHT_RECORDER_RECORDS > 0
+
+    // disabled flight recorder (LOG_XXXX never record to it because its level is LVL_NONE)
+#ifdef ARDUINO
+    class FlightRecorder : public Print {
+    public:
+        LogLevel level() const { return LogLevel::LVL_NONE; }
+        void level(const LogLevel) {}
+        bool follows_outputs() const { return false; }
+        void follow_outputs() {}
+        void begin_record() {}
+        void end_record() {}
+        using Print::write;
+        size_t write(uint8_t) override { return 1; }
+        void dump(Print*) const {}
+        void clear() {}
+    };
+#else
+    using RecordRender = void (*)(const FormatState& f, const char* args, const size_t size, std::ostream* s);
+
+    class FlightRecorder {
+    public:
+        struct Range {
+            uint64_t begin;
+            uint64_t end;
+            uint64_t size() const { return 0; }
+        };
+
+        LogLevel level() const { return LogLevel::LVL_NONE; }
+        void level(const LogLevel) {}
+        bool follows_outputs() const { return false; }
+        void follow_outputs() {}
+        void write(const LogLevel, const char*, const size_t, const size_t, const size_t) {}
+        bool write(const LogLevel, const char*, const size_t, const size_t, const size_t, const size_t, const RecordRender, const FormatState&) { return true; }
+        Range take() { return Range {0, 0}; }
+        template <typename F>
+        void for_each(const Range&, F&&, const bool = true) {}
+    };
+#endif
+
+#endif  // DEBUGLOG_FLIGHT_RECORDER_RECORDS > 0
+
+#ifdef DEBUGLOG_HAS_CRASH_HANDLER
+namespace crash {
+
+    static constexpr int SIGNALS[] {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+    static constexpr size_t N_SIGNALS {sizeof(SIGNALS) / sizeof(SIGNALS[0])};
+
+    struct State {
+        FlightRecorder* recorder {nullptr};
+        struct sigaction prev[N_SIGNALS];
+    };
+
+    inline State& state() {
+        static State s;
+        return s;
+    }
+
+    // only async-signal-safe calls are used below
+    inline void write_stderr(const char* data, size_t size) {
+        while (size) {
+            const ssize_t n = ::write(STDERR_FILENO, data, size);
+            if (n <= 0) return;
+            data += n;
+            size -= (size_t)n;
+        }
+    }
+
+    inline void write_stderr(const char* str) {
+        write_stderr(str, strlen(str));
+    }
+
+    inline void write_stderr(uint64_t v) {
+        char buf[24];
+        char* p = buf + sizeof(buf);
+        do {
+            *--p = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        write_stderr(p, (size_t)(buf + sizeof(buf) - p));
+    }
+
+    // dumps the records to stderr and calls the previous handler (or the default action)
+    inline void on_signal(const int sig) {
+        State& st = state();
+        if (st.recorder) {
+            const FlightRecorder::Range r = st.recorder->take();
+            if (r.size()) {
+                write_stderr("[WARN] DebugLog : flight recorder dump on signal ");
+                write_stderr((uint64_t)sig);
+                write_stderr(" (");
+                write_stderr(r.size());
+                write_stderr(" records)\n");
+                st.recorder->for_each(
+                    r, [](const LogLevel, const char* data, const size_t size, const size_t, const size_t) {
+                        write_stderr(data, size);
+                    },
+                    false);
+                write_stderr("[WARN] DebugLog : end of flight recorder dump\n");
+            }
+        }
+        for (size_t i = 0; i < N_SIGNALS; ++i) {
+            if (SIGNALS[i] != sig) continue;
+            sigaction(sig, &st.prev[i], nullptr);
+            break;
+        }
+        raise(sig);
+    }
+
+    inline void install(FlightRecorder* recorder) {
+        State& st = state();
+        if (st.recorder) return;
+        st.recorder = recorder;
+        struct sigaction act;
+        memset(&act, 0, sizeof(act));
+        act.sa_handler = on_signal;
+        sigemptyset(&act.sa_mask);
+        act.sa_flags = SA_RESETHAND;
+        for (size_t i = 0; i < N_SIGNALS; ++i) sigaction(SIGNALS[i], &act, &st.prev[i]);
+    }
+
+}  // namespace crash
+#endif  // DEBUGLOG_HAS_CRASH_HANDLER
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_FLIGHT_RECORDER_H
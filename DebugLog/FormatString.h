@@ -0,0 +1,257 @@
+#pragma once
+#ifndef DEBUGLOG_FORMAT_STRING_H
+#define DEBUGLOG_FORMAT_STRING_H
+
+#include "Types.h"
+
+namespace arx {
+namespace debug {
+namespace fmt {
+
+    // format string of LOG_XXXXF: "{}" is replaced with the next argument
+    // "{:d}" "{:x}" "{:o}" "{:b}" : integer (or elements of array / container) in the base
+    // "{:.N}" : floating point (or elements of array / container) with N (0 - 8) digits
+    // "{{" and "}}" : literal braces
+
+    // the string is scanned by CONSTEXPR_CHUNK characters (or brace escapes) to bound the recursion depth
+
+    // "{" of a placeholder, stray "}" or the end of the string
+    constexpr bool is_found(const char* s) {
+        return *s == '\0' || (*s == '{' && s[1] != '{') || (*s == '}' && s[1] != '}');
+    }
+
+    // stops after `n` characters (or brace escapes) if nothing is found
+    constexpr const char* find(const char* s, const size_t n) {
+        return (n == 0 || is_found(s)) ? s
+            : (*s == '{' || *s == '}') ? find(s + 2, n - 1)
+                                       : find(s + 1, n - 1);
+    }
+
+    constexpr const char* find(const char* s);
+    constexpr const char* find_from(const char* s) {
+        return is_found(s) ? s : find(s);
+    }
+
+    // "{" of the next placeholder, stray "}" or the end of the string
+    constexpr const char* find(const char* s) {
+        return find_from(find(s, CONSTEXPR_CHUNK));
+    }
+
+    // `p` is the next of "{" : '\0' for "{}", base character, '.' for precision or '?' if invalid
+    constexpr char spec(const char* p) {
+        return (*p == '}') ? '\0'
+            : (*p == ':' && (p[1] == 'd' || p[1] == 'x' || p[1] == 'o' || p[1] == 'b') && p[2] == '}') ? p[1]
+            : (*p == ':' && p[1] == '.' && p[2] >= '0' && p[2] <= '8' && p[3] == '}')                 ? '.'
+                                                                                                       : '?';
+    }
+
+    // stops after `n` characters if "}" is not found
+    constexpr const char* skip(const char* p, const size_t n) {
+        return (n == 0 || *p == '\0' || *p == '}') ? p : skip(p + 1, n - 1);
+    }
+
+    constexpr const char* skip(const char* p);
+    constexpr const char* skip_from(const char* p) {
+        return (*p == '\0') ? p : (*p == '}') ? p + 1 : skip(p);
+    }
+
+    // next of "}" which closes the placeholder
+    constexpr const char* skip(const char* p) {
+        return skip_from(skip(p, CONSTEXPR_CHUNK));
+    }
+
+    // next of the brace escape, the placeholder or the character at `s`
+    constexpr const char* next(const char* s) {
+        return ((*s == '{' || *s == '}') && s[1] == *s) ? s + 2 : (*s == '{') ? skip(s + 1) : s + 1;
+    }
+
+    // literal pieces and placeholders added by the brace escape or the placeholder at `s`
+    constexpr size_t pieces_at(const char* s) {
+        return ((*s == '{' || *s == '}') && s[1] == *s) ? 1 : (*s == '{') ? 2 : 0;
+    }
+
+    // pieces added by the next `n` characters, brace escapes or placeholders, and the next of them
+    constexpr size_t count_pieces(const char* s, const size_t n) {
+        return (n == 0 || *s == '\0') ? 0 : pieces_at(s) + count_pieces(next(s), n - 1);
+    }
+    constexpr const char* advance(const char* s, const size_t n) {
+        return (n == 0 || *s == '\0') ? s : advance(next(s), n - 1);
+    }
+
+    constexpr size_t max_pieces(const char* s, const size_t n) {
+        return (*s == '\0') ? n : max_pieces(advance(s, CONSTEXPR_CHUNK), n + count_pieces(s, CONSTEXPR_CHUNK));
+    }
+
+    // upper bound of the number of literal pieces and placeholders
+    constexpr size_t max_pieces(const char* s) {
+        return max_pieces(s, 1);
+    }
+
+    // spec is checked against the argument (or the element of array / container)
+    template <typename T>
+    struct element {
+        using type = T;
+    };
+    template <typename T>
+    struct element<Array<T>> {
+        using type = typename std::decay<T>::type;
+    };
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+    template <typename T>
+    struct element<vec_t<T>> {
+        using type = T;
+    };
+    template <typename T>
+    struct element<deq_t<T>> {
+        using type = T;
+    };
+    template <typename K, typename V>
+    struct element<map_t<K, V>> {
+        using type = V;
+    };
+#else
+    template <typename T, size_t N>
+    struct element<vec_t<T, N>> {
+        using type = T;
+    };
+    template <typename T, size_t N>
+    struct element<deq_t<T, N>> {
+        using type = T;
+    };
+    template <typename K, typename V, size_t N>
+    struct element<map_t<K, V, N>> {
+        using type = V;
+    };
+#endif
+
+    template <typename T>
+    constexpr bool accepts(const char c) {
+        using U = typename element<T>::type;
+        return (c == '\0')
+            || (c == '.' && std::is_floating_point<U>::value)
+            || (c != '.' && std::is_integral<U>::value && !std::is_same<U, bool>::value && !std::is_same<U, char>::value
+                && !std::is_same<U, signed char>::value && !std::is_same<U, unsigned char>::value);
+    }
+
+    enum class Error {
+        NONE,
+        SYNTAX,
+        TOO_FEW_ARGS,
+        TOO_MANY_ARGS,
+        SPEC_MISMATCH,
+    };
+
+    // placeholders are matched with the argument types one by one at compile time
+    template <typename... Args>
+    struct Checker;
+
+    template <>
+    struct Checker<> {
+        static constexpr Error check(const char* s) {
+            return at(find(s));
+        }
+        static constexpr Error at(const char* p) {
+            return (*p == '\0') ? Error::NONE : (*p == '}' || spec(p + 1) == '?') ? Error::SYNTAX : Error::TOO_FEW_ARGS;
+        }
+    };
+
+    template <typename Head, typename... Tail>
+    struct Checker<Head, Tail...> {
+        static constexpr Error check(const char* s) {
+            return at(find(s));
+        }
+        static constexpr Error at(const char* p) {
+            return (*p == '\0')                  ? Error::TOO_MANY_ARGS
+                : (*p == '}' || spec(p + 1) == '?') ? Error::SYNTAX
+                : !accepts<Head>(spec(p + 1))    ? Error::SPEC_MISMATCH
+                                                 : Checker<Tail...>::check(skip(p + 1));
+        }
+    };
+
+    // only for decltype() in LOG_FORMAT_SITE() (the format string is also the first argument)
+    template <size_t N, typename... Args>
+    Checker<typename std::decay<Args>::type...> checker(const char (&)[N], const Args&...);
+
+    // literal text (size > 0) or placeholder (size == 0)
+    struct Piece {
+        const char* str;
+        size_t size;
+        char spec;
+        uint8_t precision;
+    };
+
+    // format string of one LOG_XXXXF call site split into pieces at the first use
+    // literals are written as they are, so only the arguments are formatted at runtime
+    template <size_t M>
+    class Site {
+        Piece pieces[M];
+        size_t n {0};
+
+        void add(const char* str, const size_t size, const char spec = '\0', const uint8_t precision = 0) {
+            pieces[n++] = Piece {str, size, spec, precision};
+        }
+
+    public:
+        // the format string is validated by LOG_FORMAT_SITE() at compile time
+        explicit Site(const char* s) {
+            const char* lit = s;
+            while (*s != '\0') {
+                if ((*s == '{' || *s == '}') && s[1] == *s) {
+                    add(lit, (size_t)(s + 1 - lit));  // including one of the braces
+                    s += 2;
+                    lit = s;
+                } else if (*s == '{') {
+                    if (s != lit) add(lit, (size_t)(s - lit));
+                    const char c = spec(s + 1);
+                    add(nullptr, 0, c, (c == '.') ? (uint8_t)(s[3] - '0') : 0);
+                    s = skip(s + 1);
+                    lit = s;
+                } else {
+                    ++s;
+                }
+            }
+            if (s != lit) add(lit, (size_t)(s - lit));
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        const Piece& operator[](const size_t i) const {
+            return pieces[i];
+        }
+    };
+
+    // arguments of LOG_XXXXF referenced until the record is formatted
+    template <typename... Args>
+    struct Refs;
+
+    template <>
+    struct Refs<> {};
+
+    template <typename Head, typename... Tail>
+    struct Refs<Head, Tail...> {
+        const Head& head;
+        Refs<Tail...> tail;
+
+        Refs(const Head& head, const Tail&... tail)
+        : head(head), tail(tail...) {}
+    };
+
+    // printed as one argument of LOG_XXXX
+    template <size_t M, typename... Args>
+    struct Message {
+        const Site<M>& site;
+        Refs<Args...> args;
+    };
+
+    template <size_t M, size_t N, typename... Args>
+    Message<M, Args...> message(const Site<M>& site, const char (&)[N], const Args&... args) {
+        return Message<M, Args...> {site, Refs<Args...>(args...)};
+    }
+
+}  // namespace fmt
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_FORMAT_STRING_H
@@ -0,0 +1,389 @@
+#pragma once
+#ifndef DEBUGLOG_INDEXED_LOG_H
+#define DEBUGLOG_INDEXED_LOG_H
+
+#ifndef ARDUINO
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "Sink.h"
+#include "BinaryLog.h"
+
+// Indexed log format (native endianness)
+//
+// file   : "DLOGIDX1" chunk* [index]
+// chunk  : 'C' header record*
+// header : u32 payload size, u32 number of records, u32 level mask, u32 flags, u64 min time, u64 max time, u64 site bloom[4]
+// record : u64 time, u8 level, u32 size, bytes (text record as written by LOG_XXXX)
+// index  : 'I' u32 number of chunks, (u64 offset of chunk, header)*, u64 offset of index, "DLOGIDXE"
+//
+// time is nanoseconds since the epoch (std::chrono::system_clock) when the record reached the sink
+// level mask has the bit (1 << level) of each record (LVL_NONE for records without the level tag)
+// site bloom has 3 bits for "file:<file>" and "func:<func>" of each record parsed from LOG_PREAMBLE
+// the index is written when the file is closed and the chunks are scanned one by one if it is missing (e.g. crash)
+
+// records are written to the file when the chunk exceeds this size
+#ifndef DEBUGLOG_INDEXED_CHUNK_SIZE
+#define DEBUGLOG_INDEXED_CHUNK_SIZE (256 * 1024)
+#endif
+
+namespace arx {
+namespace debug {
+
+    static constexpr char INDEXED_LOG_MAGIC[] = "DLOGIDX1";
+    static constexpr char INDEXED_LOG_END[] = "DLOGIDXE";
+
+    namespace indexed {
+
+        static constexpr uint32_t FLAG_UNKNOWN_SITE {1};  // some records have no call site in the default preamble
+        static constexpr size_t HEADER_SIZE {4 * 4 + 8 * 2 + 8 * 4};
+        static constexpr size_t RECORD_HEADER_SIZE {8 + 1 + 4};
+
+        inline uint64_t now_ns() {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        inline uint64_t hash(const char* prefix, const char* s, const size_t n) {
+            uint64_t h = 14695981039346656037ull;
+            for (; *prefix; ++prefix) h = (h ^ (uint8_t)*prefix) * 1099511628211ull;
+            for (size_t i = 0; i < n; ++i) h = (h ^ (uint8_t)s[i]) * 1099511628211ull;
+            return h;
+        }
+
+        // level tag and call site of a text record ("[INFO] [time] file L.n func : ...")
+        struct RecordInfo {
+            LogLevel level {LogLevel::LVL_NONE};
+            const char* file {nullptr};
+            size_t file_size {0};
+            const char* func {nullptr};
+            size_t func_size {0};
+            int line {-1};
+        };
+
+        inline LogLevel parse_level(const char* s, const size_t n) {
+            for (int l = (int)LogLevel::LVL_ERROR; l <= (int)LogLevel::LVL_TRACE; ++l) {
+                const char* name = level_name((LogLevel)l);
+                const size_t len = strlen(name);
+                if (n == len && memcmp(s, name, n) == 0) return (LogLevel)l;
+            }
+            return LogLevel::LVL_NONE;
+        }
+
+        // only the first tokens (timestamp, LOG_CONTEXT() pairs and the preamble) are parsed
+        // so that "L.n" in the message is not taken as the call site
+        inline RecordInfo parse_record(const char* s, const size_t n) {
+            static constexpr size_t MAX_TOKENS {12};
+            RecordInfo info;
+            const char* end = s + n;
+            const char* p = s;
+            if (p != end && *p == '[') {
+                const char* close = static_cast<const char*>(memchr(p, ']', (size_t)(end - p)));
+                if (close) {
+                    info.level = parse_level(p + 1, (size_t)(close - p - 1));
+                    p = close + 1;
+                }
+            }
+            const char* tokens[MAX_TOKENS];
+            size_t sizes[MAX_TOKENS];
+            size_t n_tokens = 0;
+            while (n_tokens < MAX_TOKENS) {
+                while (p != end && *p == ' ') ++p;
+                const char* begin = p;
+                while (p != end && *p != ' ' && *p != '\n') ++p;
+                if (p == begin) break;
+                tokens[n_tokens] = begin;
+                sizes[n_tokens++] = (size_t)(p - begin);
+            }
+            for (size_t i = 1; i + 1 < n_tokens; ++i) {
+                if (sizes[i] < 3 || tokens[i][0] != 'L' || tokens[i][1] != '.') continue;
+                int line = 0;
+                size_t j = 2;
+                for (; j < sizes[i] && tokens[i][j] >= '0' && tokens[i][j] <= '9'; ++j) line = line * 10 + (tokens[i][j] - '0');
+                if (j != sizes[i]) continue;
+                info.file = tokens[i - 1];
+                info.file_size = sizes[i - 1];
+                info.func = tokens[i + 1];
+                info.func_size = sizes[i + 1];
+                info.line = line;
+                break;
+            }
+            return info;
+        }
+
+        // index of one chunk
+        struct Chunk {
+            uint64_t offset {0};  // of the payload (records) in the file
+            uint32_t payload_size {0};
+            uint32_t n_records {0};
+            uint32_t level_mask {0};
+            uint32_t flags {0};
+            uint64_t t_min {~0ull};
+            uint64_t t_max {0};
+            uint64_t bloom[4] {0, 0, 0, 0};
+
+            void add(const uint64_t time_ns, const RecordInfo& info) {
+                ++n_records;
+                level_mask |= 1u << (int)info.level;
+                if (time_ns < t_min) t_min = time_ns;
+                if (time_ns > t_max) t_max = time_ns;
+                if (!info.file) {
+                    flags |= FLAG_UNKNOWN_SITE;
+                    return;
+                }
+                set_bloom(hash("file:", info.file, info.file_size));
+                set_bloom(hash("func:", info.func, info.func_size));
+            }
+
+            // false if no record of the chunk has `name` as its file ("file:") or function ("func:")
+            bool may_have_site(const char* kind, const std::string& name) const {
+                if (flags & FLAG_UNKNOWN_SITE) return true;
+                const uint64_t h = hash(kind, name.data(), name.size());
+                for (int i = 0; i < 3; ++i) {
+                    const uint8_t bit = (uint8_t)(h >> (i * 8));
+                    if (!(bloom[bit >> 6] & (1ull << (bit & 63)))) return false;
+                }
+                return true;
+            }
+
+            void put(std::string& buf) const {
+                binary::put_u32(buf, payload_size);
+                binary::put_u32(buf, n_records);
+                binary::put_u32(buf, level_mask);
+                binary::put_u32(buf, flags);
+                binary::put_raw(buf, &t_min, sizeof(t_min));
+                binary::put_raw(buf, &t_max, sizeof(t_max));
+                binary::put_raw(buf, bloom, sizeof(bloom));
+            }
+
+            void get(const char* p) {
+                memcpy(&payload_size, p, 4);
+                memcpy(&n_records, p + 4, 4);
+                memcpy(&level_mask, p + 8, 4);
+                memcpy(&flags, p + 12, 4);
+                memcpy(&t_min, p + 16, 8);
+                memcpy(&t_max, p + 24, 8);
+                memcpy(bloom, p + 32, sizeof(bloom));
+            }
+
+        private:
+            void set_bloom(const uint64_t h) {
+                for (int i = 0; i < 3; ++i) {
+                    const uint8_t bit = (uint8_t)(h >> (i * 8));
+                    bloom[bit >> 6] |= 1ull << (bit & 63);
+                }
+            }
+        };
+
+        // f(time_ns, level, data, size) for each record in the payload of a chunk
+        // returns false if the payload is corrupted
+        template <typename F>
+        inline bool for_each_record(const std::string& payload, F&& f) {
+            size_t pos = 0;
+            while (pos + RECORD_HEADER_SIZE <= payload.size()) {
+                uint64_t time_ns;
+                uint32_t size;
+                memcpy(&time_ns, payload.data() + pos, 8);
+                const LogLevel level = (LogLevel)(uint8_t)payload[pos + 8];
+                memcpy(&size, payload.data() + pos + 9, 4);
+                pos += RECORD_HEADER_SIZE;
+                if (size > payload.size() - pos) return false;
+                f(time_ns, level, payload.data() + pos, (size_t)size);
+                pos += size;
+            }
+            return pos == payload.size();
+        }
+
+        inline bool read_index_at(std::istream& is, const uint64_t offset, const uint64_t end, std::vector<Chunk>& chunks) {
+            char tag;
+            uint32_t n;
+            is.seekg((std::streamoff)offset);
+            if (!is.get(tag) || tag != 'I' || !is.read(reinterpret_cast<char*>(&n), 4)) return false;
+            if (offset + 5 + (uint64_t)n * (8 + HEADER_SIZE) != end) return false;
+            char buf[8 + HEADER_SIZE];
+            for (uint32_t i = 0; i < n; ++i) {
+                if (!is.read(buf, sizeof(buf))) return false;
+                Chunk c;
+                memcpy(&c.offset, buf, 8);
+                c.get(buf + 8);
+                chunks.push_back(c);
+            }
+            return true;
+        }
+
+        // reads the index of the file (or scans the chunks if the index is missing)
+        // returns false if the file is not an indexed log
+        inline bool read_index(std::istream& is, std::vector<Chunk>& chunks, bool& b_has_index) {
+            chunks.clear();
+            b_has_index = false;
+            char magic[sizeof(INDEXED_LOG_MAGIC) - 1];
+            is.seekg(0);
+            if (!is.read(magic, sizeof(magic)) || memcmp(magic, INDEXED_LOG_MAGIC, sizeof(magic)) != 0) return false;
+
+            is.seekg(0, std::ios::end);
+            const uint64_t file_size = (uint64_t)is.tellg();
+            const size_t trailer_size = 8 + sizeof(INDEXED_LOG_END) - 1;
+            if (file_size >= sizeof(magic) + 1 + 4 + trailer_size) {
+                char trailer[trailer_size];
+                uint64_t index_offset;
+                is.seekg((std::streamoff)(file_size - trailer_size));
+                if (is.read(trailer, trailer_size) && memcmp(trailer + 8, INDEXED_LOG_END, trailer_size - 8) == 0) {
+                    memcpy(&index_offset, trailer, 8);
+                    if (read_index_at(is, index_offset, file_size - trailer_size, chunks)) {
+                        b_has_index = true;
+                        return true;
+                    }
+                    chunks.clear();
+                }
+            }
+
+            // a truncated chunk at the end is ignored
+            is.clear();
+            uint64_t pos = sizeof(magic);
+            char buf[1 + HEADER_SIZE];
+            while (pos + sizeof(buf) <= file_size) {
+                is.seekg((std::streamoff)pos);
+                if (!is.read(buf, sizeof(buf)) || buf[0] != 'C') break;
+                Chunk c;
+                c.get(buf + 1);
+                c.offset = pos + sizeof(buf);
+                if (c.offset + c.payload_size > file_size) break;
+                chunks.push_back(c);
+                pos = c.offset + c.payload_size;
+            }
+            is.clear();
+            return true;
+        }
+
+        inline bool read_payload(std::istream& is, const Chunk& c, std::string& payload) {
+            payload.resize(c.payload_size);
+            is.seekg((std::streamoff)c.offset);
+            return (bool)is.read(&payload[0], (std::streamsize)c.payload_size);
+        }
+
+    }  // namespace indexed
+
+    // writes records in chunks with a sparse index (level, time range and call sites of each chunk)
+    // which tools/log_search uses to skip chunks while searching
+    // records must keep the level tag of the default text format to be indexed by level
+    class IndexedFileSink : public Sink {
+        std::ofstream ofs;
+        std::mutex mtx;
+        size_t chunk_size;
+        std::string payload;
+        indexed::Chunk chunk;
+        size_t last_record {0};  // offset of the last record in the payload
+        std::vector<indexed::Chunk> chunks;
+        uint64_t offset {sizeof(INDEXED_LOG_MAGIC) - 1};
+        bool b_closed {false};
+
+    public:
+        explicit IndexedFileSink(const std::string& path, const size_t chunk_size = DEBUGLOG_INDEXED_CHUNK_SIZE)
+        : ofs(path, std::ios::binary | std::ios::trunc), chunk_size(chunk_size) {
+            ofs.write(INDEXED_LOG_MAGIC, sizeof(INDEXED_LOG_MAGIC) - 1);
+            payload.reserve(chunk_size);
+        }
+
+        ~IndexedFileSink() {
+            close();
+        }
+
+        bool is_open() const {
+            return ofs.is_open();
+        }
+
+        // data may contain several records (e.g. from the queue of LOG_ADD_SINK())
+        // a line without the level tag is a part of the previous record in data (e.g. "\n" in the message)
+        void write(const char* data, const size_t size) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            const uint64_t time_ns = indexed::now_ns();
+            const char* end = data + size;
+            bool b_first = true;
+            while (data != end) {
+                const char* nl = static_cast<const char*>(memchr(data, '\n', (size_t)(end - data)));
+                const char* next = nl ? nl + 1 : end;
+                const indexed::RecordInfo info = indexed::parse_record(data, (size_t)(next - data));
+                if (info.level == LogLevel::LVL_NONE && !b_first)
+                    append_to_last(data, (size_t)(next - data));
+                else
+                    append(time_ns, info, data, (size_t)(next - data));
+                data = next;
+                b_first = false;
+            }
+            if (payload.size() >= chunk_size) write_chunk();
+        }
+
+        // the chunk being built is written to the file (a smaller chunk)
+        void flush() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            write_chunk();
+            ofs.flush();
+        }
+
+        // writes the last chunk and the index (also done by the destructor)
+        void close() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (b_closed) return;
+            b_closed = true;
+            write_chunk();
+            std::string buf;
+            buf += 'I';
+            binary::put_u32(buf, (uint32_t)chunks.size());
+            for (const auto& c : chunks) {
+                binary::put_raw(buf, &c.offset, sizeof(c.offset));
+                c.put(buf);
+            }
+            binary::put_raw(buf, &offset, sizeof(offset));
+            buf.append(INDEXED_LOG_END, sizeof(INDEXED_LOG_END) - 1);
+            ofs.write(buf.data(), (std::streamsize)buf.size());
+            ofs.close();
+        }
+
+    private:
+        void append(const uint64_t time_ns, const indexed::RecordInfo& info, const char* data, const size_t size) {
+            last_record = payload.size();
+            binary::put_raw(payload, &time_ns, sizeof(time_ns));
+            payload += (char)info.level;
+            binary::put_u32(payload, (uint32_t)size);
+            payload.append(data, size);
+            chunk.add(time_ns, info);
+        }
+
+        void append_to_last(const char* data, const size_t size) {
+            uint32_t n;
+            memcpy(&n, &payload[last_record + 9], 4);
+            n += (uint32_t)size;
+            memcpy(&payload[last_record + 9], &n, 4);
+            payload.append(data, size);
+        }
+
+        void write_chunk() {
+            if (payload.empty()) return;
+            chunk.payload_size = (uint32_t)payload.size();
+            std::string header;
+            header += 'C';
+            chunk.put(header);
+            chunk.offset = offset + header.size();
+            ofs.write(header.data(), (std::streamsize)header.size());
+            ofs.write(payload.data(), (std::streamsize)payload.size());
+            offset = chunk.offset + payload.size();
+            chunks.push_back(chunk);
+            chunk = indexed::Chunk();
+            payload.clear();
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_INDEXED_LOG_H
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef DEBUGLOG_LINE_BUFFER_H
+#define DEBUGLOG_LINE_BUFFER_H
+
+#ifndef ARDUINO
+
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#ifndef DEBUGLOG_LINE_BUFFER_SIZE
+#define DEBUGLOG_LINE_BUFFER_SIZE 256
+#endif
+
+namespace arx {
+namespace debug {
+
+    // growable buffer for one record
+    // memory is kept after clear(), so no heap allocation happens once it has grown to the longest record
+    class LineBuffer : public std::streambuf {
+        std::vector<char> buf;
+
+    public:
+        LineBuffer()
+        : buf(DEBUGLOG_LINE_BUFFER_SIZE) {
+            clear();
+        }
+
+        const char* data() const { return pbase(); }
+        size_t size() const { return (size_t)(pptr() - pbase()); }
+
+        void clear() {
+            setp(buf.data(), buf.data() + buf.size());
+        }
+
+        void append(const char* s, const size_t n) {
+            reserve(n);
+            memcpy(pptr(), s, n);
+            pbump((int)n);
+        }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+            reserve(1);
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+            return c;
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            append(s, (size_t)n);
+            return n;
+        }
+
+    private:
+        void reserve(const size_t n) {
+            const size_t used = size();
+            if (used + n <= buf.size()) return;
+            size_t cap = buf.size() * 2;
+            while (cap < used + n) cap *= 2;
+            buf.resize(cap);
+            setp(buf.data(), buf.data() + buf.size());
+            pbump((int)used);
+        }
+    };
+
+    // the buffer is constructed before std::ostream
+    struct LineBufferHolder {
+        LineBuffer line;
+    };
+
+    // std::ostream which formats one record into LineBuffer
+    class LineStream : private LineBufferHolder, public std::ostream {
+    public:
+        LineStream()
+        : std::ostream(&line) {}
+
+        const char* data() const { return line.data(); }
+        size_t size() const { return line.size(); }
+
+        void clear_line() {
+            line.clear();
+            std::ostream::clear();
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_LINE_BUFFER_H
@@ -3,27 +3,87 @@
 #define DEBUGLOG_MANAGER_H
 
 #include "Types.h"
+#include "CallSite.h"
 #include "FileLogger.h"
+#include "Sink.h"
+#include "AsyncWriter.h"
+#include "SinkRegistry.h"
+#include "LineBuffer.h"
+#include "NumberFormat.h"
+#include "BinaryLog.h"
+#include "MmapFileLogger.h"
+#include "ShmRing.h"
+#include "IndexedLog.h"
+#include "RateLimit.h"
+#include "DropCounter.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "FlightRecorder.h"
+#include "Timestamp.h"
+#include "FormatString.h"
+#include "Coalesce.h"
+#include "SiteFilter.h"
+#include "Context.h"
 
 namespace arx {
 namespace debug {
 
     class Manager {
-        LogLevel log_lvl {DEBUGLOG_DEFAULT_LOG_LEVEL};
-        LogBase log_base {LogBase::DEC};
-        string_t delim {" "};
-        bool b_base_reset {true};
+        RelaxedAtomic<LogLevel> log_lvl {DEBUGLOG_DEFAULT_LOG_LEVEL};
+        RelaxedAtomic<bool> b_base_reset {true};
+        RelaxedAtomic<size_t> max_elems {DEBUGLOG_MAX_ELEMENTS};
+        RelaxedAtomic<size_t> max_dump_bytes {DEBUGLOG_MAX_HEXDUMP_BYTES};
+        RelaxedAtomic<OverflowPolicy> overflow {OverflowPolicy::BLOCK};
+        RelaxedAtomic<LogLevel> overflow_lvl {LogLevel::LVL_WARN};
+        FlightRecorder recorder;
+        RelaxedAtomic<LogTimestamp> ts_kind {DEBUGLOG_DEFAULT_TIMESTAMP};
+        RelaxedAtomic<uint8_t> ts_digits {DEBUGLOG_DEFAULT_TIMESTAMP_DIGITS};
+        RelaxedAtomic<uint32_t> coalesce_ms {DEBUGLOG_DEFAULT_COALESCE_MS};
+        Coalescer stream_repeats;
+        Coalescer file_repeats;
+#ifdef DEBUGLOG_HAS_SITE_FILTER
+        SiteFilter site_filter;
+#endif
 
 #ifdef ARDUINO
+        Delimiter delim {" ", 0};
+        FormatState fmt;
         Stream* stream {&Serial};
         FileLogger* logger {nullptr};
-        LogLevel file_lvl {DEBUGLOG_DEFAULT_FILE_LEVEL};
+        RelaxedAtomic<LogLevel> file_lvl {DEBUGLOG_DEFAULT_FILE_LEVEL};
         bool b_auto_save {false};
-        LogPrecision log_precision {LogPrecision::TWO};
+        FlushPolicy flush_policy;
+        DropCounter drops;
+#else
+        // configuration is read lock-free on the log path
+        // and config_mtx only serializes the configuration calls
+        SharedSnapshot<Delimiter> delim;
+        std::atomic<uint32_t> delim_id {0};
+        stream_t* stream {&std::cout};
+        SharedSnapshot<AsyncWriter> async;
+        SharedSnapshot<timestamp::Format> ts_format;
+        uint32_t ts_format_id {0};
+        SharedSnapshot<BinaryLogger> binary;
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+        SharedSnapshot<MmapFileLogger> logger;
+        RelaxedAtomic<LogLevel> file_lvl {DEBUGLOG_DEFAULT_FILE_LEVEL};
+#endif
+        SinkRegistry sinks;
+        RelaxedAtomic<uint32_t> report_ms {0};
+        RelaxedAtomic<uint32_t> next_report_ms {0};
+        std::mutex config_mtx;
 #endif
 
         // singleton
+#ifdef ARDUINO
         Manager() {}
+#else
+        Manager() {
+            delim.store(new Delimiter {" ", 0});
+            ts_format.store(new timestamp::Format {DEBUGLOG_DEFAULT_TIMESTAMP_FORMAT, 0});
+            timestamp::start_ns();
+        }
+#endif
         Manager(const Manager&) = delete;
         Manager& operator=(const Manager&) = delete;
 
@@ -34,19 +94,211 @@ namespace debug {
         }
 
         LogLevel log_level() const {
-            return log_lvl;
+            return log_lvl.load();
         }
 
         void log_level(const LogLevel l) {
-            log_lvl = l;
+            log_lvl.store(l);
         }
 
+        // LOG_XXXX check this before their arguments are evaluated
+        bool is_enabled(const LogLevel level) const {
+            if (level == LogLevel::LVL_NONE) return false;
+#ifdef ARDUINO
+            if (logger && (int)level <= (int)file_lvl.load()) return true;
+#elif defined(DEBUGLOG_HAS_MMAP_FILE_LOGGER)
+            if ((int)level <= (int)file_lvl.load() && logger.load()) return true;
+#endif
+#ifndef ARDUINO
+            if ((int)level <= (int)sinks.max_level()) return true;
+#endif
+            if ((int)level <= (int)log_lvl.load()) return true;
+            if ((int)level <= (int)recorder.level()) return true;
+#ifndef ARDUINO
+            stats::on_filtered();
+#endif
+            return false;
+        }
+
+#ifdef DEBUGLOG_HAS_SITE_FILTER
+        // LOG_XXXX check the state of the call site after SiteSlot::is_off() (the only check of a disabled site)
+        static bool is_enabled(FilterSite& site, const LogLevel level, const char* file, const int line, const char* func) {
+            const uint8_t s = site.state.load();
+            return (s == FilterSite::ON) || get().is_enabled(s, site, level, file, line, func);
+        }
+
+        // call sites matching `pattern` ("file:<name>", "func:<name>", "line:<n>" or "*") are written up to `level`
+        // regardless of LOG_SET_LEVEL() and disabled above it (later patterns override earlier ones)
+        bool site_level(const string_t& pattern, const LogLevel level) {
+            return site_filter.set(pattern, level);
+        }
+
+        void reset_sites() {
+            site_filter.reset();
+        }
+
+        // "[LEVEL] <file> L.<line> <func> : <default / on / off>" of the call sites executed so far
+        void print_sites() {
+            site_filter.for_each([this](const FilterSite& s) {
+                static const char* const states[] = {"", "default", "on", "off"};
+#ifdef ARDUINO
+                println(string_t(generate_header(s.level)) + s.file, string_t("L.") + s.line, s.func, ":", states[s.state.load()]);
+#else
+                println(string_t(generate_header(s.level)) + s.file, "L." + std::to_string(s.line), s.func, ":", states[s.state.load()]);
+#endif
+            });
+        }
+#endif
+
         void delimiter(const string_t& del) {
-            delim = del;
+#ifdef ARDUINO
+            delim.str = del;
+            ++delim.id;
+#else
+            std::lock_guard<std::mutex> lock(config_mtx);
+            delim.store(new Delimiter {del, ++delim_id});
+            if (BinaryLogger* b = binary.load()) b->delimiter(del);
+#endif
         }
 
         void base_reset(const bool b) {
-            b_base_reset = b;
+            b_base_reset.store(b);
+        }
+
+        // arrays / containers longer than this are cut with "... (N more)" (0: unlimited)
+        void max_elements(const size_t n) {
+            max_elems.store(n);
+        }
+
+        size_t max_elements() const {
+            return max_elems.load();
+        }
+
+        // hexdump longer than this is cut with "... (N more bytes)" (0: unlimited)
+        void max_bytes(const size_t n) {
+            max_dump_bytes.store(n);
+        }
+
+        size_t max_bytes() const {
+            return max_dump_bytes.load();
+        }
+
+        // applied when the async queue (C++) or the TX buffer of Serial (Arduino) is full
+        // DROP_BELOW drops records which are less severe than `level`
+        void overflow_policy(const OverflowPolicy p, const LogLevel level = LogLevel::LVL_WARN) {
+            overflow_lvl.store(level);
+            overflow.store(p);
+#ifndef ARDUINO
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (AsyncWriter* a = async.load()) a->overflow_policy(p, level);
+#endif
+        }
+
+        OverflowPolicy overflow_policy() const {
+            return overflow.load();
+        }
+
+        // records dropped by OverflowPolicy (C++: since LOG_ASYNC_START())
+        uint32_t dropped(const LogLevel level) const {
+#ifndef ARDUINO
+            const SnapshotGuard guard;
+#endif
+            const DropCounter* d = drop_counter();
+            return d ? d->count(level) : 0;
+        }
+
+        uint32_t dropped() const {
+#ifndef ARDUINO
+            const SnapshotGuard guard;
+#endif
+            const DropCounter* d = drop_counter();
+            return d ? d->count() : 0;
+        }
+
+        // called once per call site by LOG_CALLSITE()
+        CallSite callsite(const char* file, const char* line, const char* func) const {
+#ifdef ARDUINO
+            return CallSite(file, line, func);
+#else
+            const SnapshotGuard guard;
+            const Delimiter& d = delimiter();
+            return CallSite(file, line, func, d.str, d.id);
+#endif
+        }
+
+        // LOG_XXXX have the timestamp after the level tag ("[INFO] 12.345678 ...")
+        // `digits` of a second are 0, 3, 6 or 9 (up to 6 on Arduino)
+        void timestamp(const LogTimestamp t, const uint8_t digits = DEBUGLOG_DEFAULT_TIMESTAMP_DIGITS) {
+            ts_digits.store(digits);
+            ts_kind.store(t);
+        }
+
+        LogTimestamp timestamp() const {
+            return ts_kind.load();
+        }
+
+        // identical consecutive records are written once to each output (std::cout, the file and each sink)
+        // "last message repeated N times" is written before the next different record, or every `interval_ms` while repeating
+        void coalesce(const uint32_t interval_ms) {
+            coalesce_ms.store(interval_ms);
+        }
+
+        uint32_t coalesce() const {
+            return coalesce_ms.load();
+        }
+
+        // renders "key=value " of LOG_CONTEXT() into `buf` with the default base and precision
+        // returns 0 (nothing is added to the context) if it does not fit in `cap` bytes
+        template <typename T>
+        size_t render_context(char* buf, const size_t cap, const char* key, const T& value) {
+            const FormatState prev = format();
+            format() = FormatState();
+#ifdef ARDUINO
+            ContextWriter w(buf, cap);
+            print_one(key, &w);
+            print_one("=", &w);
+            print_one(value, &w);
+            print_one(" ", &w);
+            format() = prev;
+            return w.size();
+#else
+            LineStream& ls = context_stream();
+            ls.clear_line();
+            print_one(key, &ls);
+            print_one("=", &ls);
+            print_one(value, &ls);
+            print_one(" ", &ls);
+            format() = prev;
+            if (ls.size() > cap) return 0;
+            memcpy(buf, ls.data(), ls.size());
+            return ls.size();
+#endif
+        }
+
+        // LOG_XXXX are also kept in the flight recorder if the level is equal to or lower than `level`
+        // (even if they are not written anywhere, so their arguments are evaluated)
+        // the most verbose level of the outputs is returned while the recorder follows them
+        LogLevel recorder_level() const {
+            if (!recorder.follows_outputs()) return recorder.level();
+            int l = (int)log_lvl.load();
+#ifdef ARDUINO
+            if (logger && (int)file_lvl.load() > l) l = (int)file_lvl.load();
+#else
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            if (logger.load() && (int)file_lvl.load() > l) l = (int)file_lvl.load();
+#endif
+            if ((int)sinks.max_level() > l) l = (int)sinks.max_level();
+#endif
+            return (LogLevel)l;
+        }
+
+        void recorder_level(const LogLevel l) {
+            recorder.level(l);
+        }
+
+        // only the records written to any output are kept (until the next recorder_level())
+        void recorder_follow_outputs() {
+            recorder.follow_outputs();
         }
 
 #ifdef ARDUINO
@@ -73,6 +325,7 @@ namespace debug {
             if (!b) {
                 string_t str = string_t("[ASSERT] ") + file + string_t(" ") + line + string_t(" ") + func + string_t(" : ") + expr;
                 if (msg.length()) str += string_t(" => ") + msg;
+                dump_recorder();
                 stream->println(str);
                 if (logger) {
                     logger->println(str);
@@ -83,13 +336,22 @@ namespace debug {
             }
         }
 
+        // records kept by the flight recorder since the last dump are written to the stream and the file
+        void dump_recorder() {
+            recorder.dump(stream);
+            if (logger) recorder.dump(logger);
+            recorder.clear();
+        }
+
         bool is_open() const {
             if (logger) return logger->is_open();
             return false;
         }
 
         void flush() {
-            if (logger) logger->flush();
+            if (!logger) return;
+            flush_repeats(file_repeats, true, [this](const char* data, const size_t size) { logger->write(data, size); });
+            logger->flush();
         }
 
         void close() {
@@ -99,113 +361,888 @@ namespace debug {
         }
 
         LogLevel file_level() const {
-            return file_lvl;
+            return file_lvl.load();
         }
 
         void file_level(const LogLevel l) {
-            file_lvl = l;
+            file_lvl.store(l);
+        }
+
+        // auto save flushes the file after `bytes` bytes, `records` records or `interval_ms` ms
+        // the interval is checked when the next record is written
+        void file_flush_policy(const FlushPolicy& policy) {
+            flush_policy = policy;
+        }
+
+#else  // ARDUINO
+
+        ~Manager() {
+            async_stop();
+            binary_close();
+            sinks.clear();
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            close();
+#endif
+        }
+
+        // LOG_XXXX are also written to the sink if the level is equal to or lower than `level`
+        // formatter == nullptr : same text as std::cout
+        // queue_bytes > 0 : written in batches by its own thread (records are dropped if the queue is full)
+        // returns the id of the sink (0 if failed)
+        uint32_t add_sink(const std::shared_ptr<Sink>& sink, const LogLevel level = DEBUGLOG_DEFAULT_LOG_LEVEL, const std::shared_ptr<Formatter>& formatter = nullptr, const size_t queue_bytes = 0) {
+            return sinks.add(sink, level, formatter, queue_bytes);
+        }
+
+        // queued records are written before the sink is removed
+        bool remove_sink(const uint32_t id) {
+            return sinks.remove(id);
+        }
+
+        LogLevel sink_level(const uint32_t id) const {
+            return sinks.level(id);
+        }
+
+        void sink_level(const uint32_t id, const LogLevel l) {
+            sinks.level(id, l);
+        }
+
+        // sinks with a queue drop new records when the queue is full by default
+        void sink_overflow_policy(const uint32_t id, const OverflowPolicy p, const LogLevel level = LogLevel::LVL_WARN) {
+            sinks.overflow_policy(id, p, level);
+        }
+
+        uint32_t sink_dropped(const uint32_t id, const LogLevel level) const {
+            return sinks.dropped(id, level);
+        }
+
+        uint32_t sink_dropped(const uint32_t id) const {
+            return sinks.dropped(id);
+        }
+
+        void flush_sinks() {
+            sinks.flush();
+        }
+
+        // counters and latency histograms of all threads (zero unless DEBUGLOG_ENABLE_STATS is defined)
+        StatsSnapshot stats() const {
+            StatsSnapshot s = StatsSnapshot::collect();
+            s.dropped = dropped() + sinks.dropped();
+            return s;
+        }
+
+        // LOG_XXXX write "[INFO] DebugLog stats : ..." every `ms` milliseconds (0: disabled)
+        // only if DEBUGLOG_ENABLE_STATS is defined
+        void stats_report_interval(const uint32_t ms) {
+            next_report_ms.store(now_ms() + ms);
+            report_ms.store(ms);
+        }
+
+        // writes LOG_SCOPE / LOG_TRACE_BEGIN / LOG_TRACE_END events of all threads as Chrome trace event JSON
+        // "[WARN] DebugLog : N trace events dropped ..." is written if a thread has more than DEBUGLOG_TRACE_MAX_EVENTS
+        bool trace_export(const std::string& path) {
+            const bool b = trace::export_json(path);
+            report_trace_drops();
+            return b;
+        }
+
+        void trace_export(std::ostream& os) {
+            trace::export_json(os);
+            report_trace_drops();
+        }
+
+        // the events recorded so far are no longer exported and their memory is released
+        void trace_clear() {
+            trace::clear();
+        }
+
+        // strftime() format of the date and time of LogTimestamp::LOCAL and UTC (the fraction is appended to it)
+        void timestamp_format(const std::string& fmt) {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            ts_format.store(new timestamp::Format {fmt, ++ts_format_id});
+        }
+
+        // ASSERT: the flight recorder and "[ASSERT] ..." are written to all outputs, and then abort()
+        void assertion(const bool b, const char* file, const int line, const char* func, const char* expr, const string_t& msg = "") {
+            if (b) return;
+            const SnapshotGuard guard;
+            string_t str = string_t("[ASSERT] ") + file + " " + std::to_string(line) + " " + func + " : " + expr;
+            if (!msg.empty()) str += " => " + msg;
+            str += "\n";
+            dump_recorder();
+            write_direct(LogLevel::LVL_ERROR, str.data(), str.size(), strlen("[ASSERT] "), 0);
+            stream->flush();
+            sinks.flush();
+            binary_flush();
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            flush();
+#endif
+            std::abort();
+        }
+
+        // records kept by the flight recorder since the last dump are written to std::cout, the file and the sinks
+        // regardless of their log levels
+        void dump_recorder() {
+            const FlightRecorder::Range r = recorder.take();
+            if (r.size() == 0) return;
+            const SnapshotGuard guard;
+            async_flush();
+            const char* header = generate_header(LogLevel::LVL_WARN);
+            const string_t begin = string_t(header) + "DebugLog : flight recorder dump (" + std::to_string(r.size()) + " records)\n";
+            write_direct(LogLevel::LVL_WARN, begin.data(), begin.size(), strlen(header), 0);
+            recorder.for_each(r, [this](const LogLevel level, const char* data, const size_t size, const size_t header_size, const size_t time_size) {
+                write_direct(level, data, size, header_size, time_size);
+            });
+            const string_t end = string_t(header) + "DebugLog : end of flight recorder dump\n";
+            write_direct(LogLevel::LVL_WARN, end.data(), end.size(), strlen(header), 0);
+            stream->flush();
+        }
+
+#ifdef DEBUGLOG_HAS_CRASH_HANDLER
+        // the flight recorder is dumped to stderr on SIGSEGV, SIGABRT, SIGBUS, SIGFPE and SIGILL
+        // and then the previous handler (or the default action) is invoked
+        void recorder_handle_signals() {
+            crash::install(&recorder);
+        }
+#endif
+
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+        // LOG_XXXX are also written to the memory-mapped file depending on file_level
+        // the file is rotated every segment_size bytes and at most max_files files are kept
+        void attach(const std::string& path, const size_t segment_size = DEBUGLOG_MMAP_SEGMENT_SIZE, const size_t max_files = DEBUGLOG_MMAP_MAX_FILES) {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (MmapFileLogger* f = logger.load()) f->close();
+            logger.store(new MmapFileLogger(path, segment_size, max_files));
+        }
+
+        bool is_open() const {
+            const SnapshotGuard guard;
+            MmapFileLogger* f = logger.load();
+            return f && f->is_open();
+        }
+
+        void flush() {
+            const SnapshotGuard guard;
+            if (MmapFileLogger* f = logger.load()) {
+                flush_repeats(file_repeats, true, [f](const char* data, const size_t size) { f->write(data, size); });
+                f->flush();
+                stats::on_flush();
+            }
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (MmapFileLogger* f = logger.load()) f->close();
+            logger.reset();
+        }
+
+        LogLevel file_level() const {
+            return file_lvl.load();
+        }
+
+        void file_level(const LogLevel l) {
+            file_lvl.store(l);
+        }
+#endif
+
+        // LOG_XXXX, PRINT and PRINTLN are queued to the lock-free ring
+        // and written to std::cout by the background thread
+        void async_start(const size_t n_bytes = DEBUGLOG_ASYNC_BUFFER_SIZE) {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (is_async()) return;
+            AsyncWriter* a = async.load();
+            if (a) {
+                a->overflow_policy(overflow.load(), overflow_lvl.load());
+                a->restart(n_bytes);  // the stopped writer is reused
+                return;
+            }
+            a = async.store(new AsyncWriter(stream, n_bytes));
+            a->overflow_policy(overflow.load(), overflow_lvl.load());
+        }
+
+        // write all queued logs and go back to synchronous mode
+        void async_stop() {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (AsyncWriter* a = async.load()) a->stop();  // kept for the next async_start() without the ring
+        }
+
+        // block until all logs queued before this call are written
+        void async_flush() {
+            const SnapshotGuard guard;
+            flush_repeats(stream_repeats, true, [this](const char* data, const size_t size) { write_stream(data, size, LogLevel::LVL_NONE); });
+            if (AsyncWriter* a = async.load()) a->flush();
+        }
+
+        bool is_async() const {
+            const SnapshotGuard guard;
+            AsyncWriter* a = async.load();
+            return a && a->is_running();
+        }
+
+        // LOG_XXXX only write call site id and raw arguments to the file
+        // if DEBUGLOG_ENABLE_BINARY_LOG is defined (decode it with tools/binary_log_decoder)
+        void binary_attach(const std::string& path) {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (BinaryLogger* b = binary.load()) b->close();
+            binary.store(new BinaryLogger(path, delimiter().str));
+        }
+
+        void binary_flush() {
+            const SnapshotGuard guard;
+            if (BinaryLogger* b = binary.load()) {
+                b->flush();
+                stats::on_flush();
+            }
+        }
+
+        void binary_close() {
+            std::lock_guard<std::mutex> lock(config_mtx);
+            if (BinaryLogger* b = binary.load()) b->close();
+            binary.reset();
+        }
+
+        bool is_binary_open() const {
+            const SnapshotGuard guard;
+            BinaryLogger* b = binary.load();
+            return b && b->is_open();
+        }
+
+        template <typename... Args>
+        void log_binary(BinarySite& site, const SiteLevel& sl, Args&&... args) {
+            if (((int)site.level > (int)log_lvl.load() && !sl.b_forced) || site.level == LogLevel::LVL_NONE) return;
+            const SnapshotGuard guard;
+            if (BinaryLogger* b = binary.load()) {
+                update_format();  // reset after the header as print_header() does
+                b->log(site, format(), args...);
+                update_format(args...);
+                return;
+            }
+            // text log until the binary logger is attached
+            log(sl, site.file, "L." + std::to_string(site.line), site.func, ":", std::forward<Args>(args)...);
         }
 
 #endif  // ARDUINO
 
         template <typename... Args>
         void log(const LogLevel level, Args&&... args) {
-            bool b_ignore = (log_lvl == LogLevel::LVL_NONE);
-#ifdef ARDUINO
-            b_ignore &= (file_lvl == LogLevel::LVL_NONE);
+            log(SiteLevel {level, false}, std::forward<Args>(args)...);
+        }
+
+        // LOG_XXXX: the record of the call site forced on by LOG_SET_SITE_LEVEL() ignores LOG_SET_LEVEL()
+        template <typename... Args>
+        void log(const SiteLevel& sl, Args&&... args) {
+#ifndef ARDUINO
+            const uint64_t t0 = stats::now_ns();
+#endif
+            const LogLevel level = sl.level;
+            const LogLevel lvl = sl.b_forced ? LogLevel::LVL_TRACE : log_lvl.load();
+#if defined(ARDUINO) || defined(DEBUGLOG_HAS_MMAP_FILE_LOGGER)
+            const LogLevel flvl = file_lvl.load();
+#endif
+            bool b_ignore = (lvl == LogLevel::LVL_NONE);
+#if defined(ARDUINO) || defined(DEBUGLOG_HAS_MMAP_FILE_LOGGER)
+            b_ignore &= (flvl == LogLevel::LVL_NONE);
 #endif
+#ifndef ARDUINO
+            const LogLevel slvl = sinks.max_level();
+            b_ignore &= (slvl == LogLevel::LVL_NONE);
+#endif
+            bool b_record = (int)level <= (int)recorder.level();
+            b_ignore &= !b_record;
             b_ignore |= (level == LogLevel::LVL_NONE);
             if (b_ignore) return;
+#ifndef ARDUINO
+            const SnapshotGuard guard;  // the configuration objects below are used until the record is written
+#endif
 
-            string_t header = generate_header(level);
-            if ((int)level <= (int)log_lvl) {
-                print(header);  // to avoid delimiter after header
-                println(std::forward<Args>(args)...);
-            }
+            const char* header = generate_header(level);
+            char ts[timestamp::BUFFER_SIZE + 1];
+            const size_t ts_size = make_timestamp(ts);
 #ifdef ARDUINO
+            const uint64_t key = coalesce_ms.load() ? record_key(level, std::forward<Args>(args)...) : 0;
+            const auto to_stream = [this](const char* data, const size_t size) { stream->write(data, size); };
+            if ((int)level > (int)lvl) {
+                if (key) flush_repeats(stream_repeats, false, to_stream);
+            } else if (coalesce_to(stream_repeats, key, ts, ts_size, to_stream) && !drop_if_full(level)) {
+                stream_t* s = begin_record();
+                print_header(s, header, ts, ts_size);
+                print_context(s);
+                println_to(s, std::forward<Args>(args)...);
+                end_record(s);
+            }
+            b_record |= recorder.follows_outputs() && ((int)level <= (int)lvl || (logger && (int)level <= (int)flvl));
+            if (b_record) {
+                recorder.begin_record();
+                print_header(&recorder, header, ts, ts_size);
+                print_context(&recorder);
+                println_to(&recorder, std::forward<Args>(args)...);
+                recorder.end_record();
+            }
             if (!logger) return;
-            if ((int)level <= (int)file_lvl) {
-                print_file(header);  // to avoid delimiter after header
-                println_file(std::forward<Args>(args)...);
+            if ((int)level <= (int)flvl) {
+                bool b_written = false;
+                const auto to_file = [this, &b_written](const char* data, const size_t size) {
+                    logger->write(data, size);
+                    b_written = true;
+                };
+                if (coalesce_to(file_repeats, key, ts, ts_size, to_file)) {
+                    print_header(logger, header, ts, ts_size);
+                    print_context(logger);
+                    println_to(logger, std::forward<Args>(args)...);
+                    b_written = true;
+                }
+                if (b_auto_save && b_written) logger->commit(flush_policy, level == LogLevel::LVL_ERROR);
+            } else if (key) {
+                flush_repeats(file_repeats, false, [this](const char* data, const size_t size) { logger->write(data, size); });
             }
+#else
+            // the record is formatted once and written to std::cout, the file and the sinks
+            bool b_stream = (int)level <= (int)lvl;
+            const bool b_sinks = (int)level <= (int)slvl;
+            MmapFileLogger* f = nullptr;
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            if ((int)level <= (int)flvl) f = logger.load();
+#endif
+            if (!b_stream && !f && !b_sinks) {
+                if (!b_record) {
+                    stats::on_filtered();
+                    return;
+                }
+                // kept only in the flight recorder: formatted when it is dumped
+                if (record_raw(level, header, ts, ts_size, args...)) {
+                    stats::on_record(level, t0);
+                    return;
+                }
+            }
+            b_record |= recorder.follows_outputs();
+            stream_t* s = begin_record();
+            print_header(s, header, ts, ts_size);
+            const size_t header_size = record_size(s);
+            const size_t time_size = ts_size ? ts_size - 1 : 0;
+            print_context(s);  // a part of the body, so records of different contexts are not coalesced
+            println_to(s, std::forward<Args>(args)...);
+            if (s != stream) {
+                const LineStream& ls = static_cast<const LineStream&>(*s);
+                const uint32_t cms = coalesce_ms.load();
+                const uint64_t key = cms ? coalesce::make_key(level, coalesce::hash(ls.data() + header_size, ls.size() - header_size)) : 0;
+                if (b_record) recorder.write(level, ls.data(), ls.size(), header_size, time_size);
+                if (b_sinks) sinks.write(level, ls.data(), ls.size(), header_size, time_size, true, key, cms);
+                if (key) {
+                    const auto to_stream = [this, level](const char* data, const size_t size) { write_stream(data, size, level); };
+                    if (b_stream)
+                        b_stream = coalesce_to(stream_repeats, key, ts, ts_size, to_stream);
+                    else
+                        flush_repeats(stream_repeats, false, to_stream);
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+                    MmapFileLogger* file = f ? f : logger.load();
+                    const auto to_file = [file](const char* data, const size_t size) { file->write(data, size); };
+                    if (f) {
+                        if (!coalesce_to(file_repeats, key, ts, ts_size, to_file)) f = nullptr;
+                    } else if (file) {
+                        flush_repeats(file_repeats, false, to_file);
+                    }
+#endif
+                }
+            }
+            end_record(s, b_stream, f, level);
+            stats::on_record(level, t0);
+#ifdef DEBUGLOG_ENABLE_STATS
+            if (report_ms.load()) report_stats_if_due();
+#endif
 #endif
         }
 
         // ===== print / println =====
 
-        void print() {
-            if (b_base_reset) log_base = LogBase::DEC;
+        template <typename... Args>
+        void print(Args&&... args) {
+#ifndef ARDUINO
+            const SnapshotGuard guard;
+#endif
+            stream_t* s = begin_record();
+            print_to(s, std::forward<Args>(args)...);
+            end_record(s);
+        }
+
+        template <typename... Args>
+        void println(Args&&... args) {
+#ifndef ARDUINO
+            const SnapshotGuard guard;
+#endif
+            stream_t* s = begin_record();
+            println_to(s, std::forward<Args>(args)...);
+            end_record(s);
         }
 
-        template <typename Head, typename... Tail>
-        void print(const Head& head, Tail&&... tail) {
 #ifdef ARDUINO
-            print_one(head, stream);
-            if (sizeof...(tail) != 0)
-                print_one(delim, stream);
-#else
-            print_one(head);
-            if (sizeof...(tail) != 0)
-                print_one(delim);
+        template <typename... Args>
+        void print_file(Args&&... args) {
+            if (!logger) return;
+            print_to(logger, std::forward<Args>(args)...);
+            if (b_auto_save) logger->commit(flush_policy, false);
+        }
+
+        template <typename... Args>
+        void println_file(Args&&... args) {
+            if (!logger) return;
+            println_to(logger, std::forward<Args>(args)...);
+            if (b_auto_save) logger->commit(flush_policy, false);
+        }
+#elif defined(DEBUGLOG_HAS_MMAP_FILE_LOGGER)
+        template <typename... Args>
+        void print_file(Args&&... args) {
+            const SnapshotGuard guard;
+            MmapFileLogger* f = logger.load();
+            if (!f) return;
+            stream_t* s = begin_record();
+            print_to(s, std::forward<Args>(args)...);
+            end_record(s, false, f);
+        }
+
+        template <typename... Args>
+        void println_file(Args&&... args) {
+            const SnapshotGuard guard;
+            MmapFileLogger* f = logger.load();
+            if (!f) return;
+            stream_t* s = begin_record();
+            println_to(s, std::forward<Args>(args)...);
+            end_record(s, false, f);
+        }
 #endif
-            print(std::forward<Tail>(tail)...);
+
+    private:
+#ifdef DEBUGLOG_HAS_SITE_FILTER
+        // the call site is not forced on
+        bool is_enabled(uint8_t state, FilterSite& site, const LogLevel level, const char* file, const int line, const char* func) {
+            if (state == FilterSite::OFF) return false;  // disabled after SiteSlot::is_off()
+            if (state == FilterSite::UNREGISTERED) {
+                site_filter.add(site, level, file, line, func);
+                state = site.state.load();
+                if (state != FilterSite::DEFAULT) return state == FilterSite::ON;
+            }
+            return is_enabled(level);
         }
+#endif
 
-        void println() {
 #ifdef ARDUINO
-            print_one("\n", stream);
+        const Delimiter& delimiter() const {
+            return delim;
+        }
+
+        FormatState& format() {
+            return fmt;
+        }
 #else
-            print_one("\n");
+        const Delimiter& delimiter() const {
+            return *delim.load();
+        }
+
+        static FormatState& format() {
+            static thread_local FormatState f;
+            return f;
+        }
 #endif
-            if (b_base_reset) log_base = LogBase::DEC;
+
+        template <typename S>
+        void print_to(S*) {
+            if (b_base_reset.load()) format().base = LogBase::DEC;
+        }
+
+        template <typename S, typename Head, typename... Tail>
+        void print_to(S* s, const Head& head, Tail&&... tail) {
+            print_one(head, s);
+            if (sizeof...(tail) != 0)
+                print_one(delimiter().str, s);
+            print_to(s, std::forward<Tail>(tail)...);
+        }
+
+        template <typename S>
+        void println_to(S* s) {
+            print_one("\n", s);
+            if (b_base_reset.load()) format().base = LogBase::DEC;
+        }
+
+#ifndef ARDUINO
+        // the format state is changed in the same way as println_to() for the records which are not printed (binary log)
+        void update_format() {
+            if (b_base_reset.load()) format().base = LogBase::DEC;
         }
 
         template <typename Head, typename... Tail>
-        void println(const Head& head, Tail&&... tail) {
+        void update_format(const Head& head, const Tail&... tail) {
+            update_format_one(head);
+            update_format(tail...);
+        }
+
+        template <typename T>
+        static void update_format_one(const T&) {}
+        static void update_format_one(const LogBase& b) { format().base = b; }
+        static void update_format_one(const LogPrecision& p) { format().precision = (int)p; }
+
+        // ===== compact records of the flight recorder =====
+        // a record kept only in the flight recorder is not formatted: numbers and strings are copied as they are
+        // (other arguments are formatted one by one), and the record is formatted by print_raw() when it is dumped
+
+        enum class RawKind {
+            NUMBER,  // raw bytes of the value
+            TEXT,    // u32 length and bytes (strings as they are, other arguments formatted)
+        };
+
+        template <typename T, typename U = typename std::decay<T>::type>
+        using raw_kind = std::integral_constant<RawKind,
+            (std::is_arithmetic<U>::value || std::is_same<U, LogBase>::value || std::is_same<U, LogPrecision>::value)
+                ? RawKind::NUMBER
+                : RawKind::TEXT>;
+
+        template <typename... Args>
+        struct RawTypes {};
+
+        // false if the record is not kept (the raw arguments do not fit in a slot, or operator<< of an argument logs)
+        template <typename... Args>
+        bool record_raw(const LogLevel level, const char* header, const char* ts, const size_t ts_size, const Args&... args) {
+            if (line_stream_busy()) return false;
+            static thread_local std::string buf;
+            buf.clear();
+            buf.append(header).append(ts, ts_size);
+            const size_t header_size = buf.size();
+            const Context& c = Context::get();
+            buf.append(c.data, c.size);
+
+            update_format();  // reset after the header as print_header() does
+            const FormatState f = format();
+            size_t text_size = buf.size();
+            line_stream_busy() = true;
+            const RecordRender render = put_raw_args(buf, text_size, args...);
+            line_stream_busy() = false;
+            update_format();  // reset after the record as println_to() does
+            if (recorder.write(level, buf.data(), buf.size(), header_size, ts_size ? ts_size - 1 : 0, text_size, render, f)) return true;
+            format() = f;  // formatted again as a text record
+            return false;
+        }
+
+        // the first argument (the preamble of LOG_XXXX) is a part of the text if it is not a number,
+        // so the call site is also written by the signal handler
+        RecordRender put_raw_args(std::string&, size_t&) {
+            return &Manager::print_raw<>;
+        }
+
+        template <typename Head, typename... Tail>
+        RecordRender put_raw_args(std::string& buf, size_t& text_size, const Head& head, const Tail&... tail) {
+            return put_raw_head(buf, text_size, raw_kind<Head>(), head, tail...);
+        }
+
+        template <typename Head, typename... Tail>
+        RecordRender put_raw_head(std::string& buf, size_t&, std::integral_constant<RawKind, RawKind::NUMBER>, const Head& head, const Tail&... tail) {
+            put_raw(buf, head, tail...);
+            return &Manager::print_raw<typename std::decay<Head>::type, typename std::decay<Tail>::type...>;
+        }
+
+        template <typename Head, typename... Tail>
+        RecordRender put_raw_head(std::string& buf, size_t& text_size, std::integral_constant<RawKind, RawKind::TEXT>, const Head& head, const Tail&... tail) {
+            append_text(buf, head);
+            if (sizeof...(Tail) != 0) buf.append(delimiter().str);
+            text_size = buf.size();
+            put_raw(buf, tail...);
+            return &Manager::print_raw<typename std::decay<Tail>::type...>;
+        }
+
+        void put_raw(std::string&) {}
+
+        template <typename Head, typename... Tail>
+        void put_raw(std::string& buf, const Head& head, const Tail&... tail) {
+            put_raw_one(buf, head, raw_kind<Head>());
+            put_raw(buf, tail...);
+        }
+
+        template <typename T>
+        void put_raw_one(std::string& buf, const T& v, std::integral_constant<RawKind, RawKind::NUMBER>) {
+            buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+            update_format_one(v);  // for the arguments formatted after this
+        }
+
+        template <typename T>
+        void put_raw_one(std::string& buf, const T& v, std::integral_constant<RawKind, RawKind::TEXT>) {
+            const size_t pos = buf.size();
+            buf.append(sizeof(uint32_t), '\0');
+            append_text(buf, v);
+            const uint32_t n = (uint32_t)(buf.size() - pos - sizeof(uint32_t));
+            memcpy(&buf[pos], &n, sizeof(n));
+        }
+
+        // strings as they are and other arguments formatted
+        void append_text(std::string& buf, const char* v) {
+            buf.append(v);
+        }
+
+        void append_text(std::string& buf, const string_t& v) {
+            buf.append(v);
+        }
+
+        void append_text(std::string& buf, const CallSite& v) {
+            const Delimiter& d = delimiter();
+            if (v.delim_id == d.id)
+                buf.append(v.text);
+            else
+                buf.append(v.file).append(d.str).append(v.line).append(d.str).append(v.func).append(d.str).append(":");
+        }
+
+        template <typename T>
+        void append_text(std::string& buf, const T& v) {
+            LineStream& ls = raw_stream();
+            ls.clear_line();
+            print_one(v, static_cast<stream_t*>(&ls));
+            buf.append(ls.data(), ls.size());
+        }
+
+        // RecordRender of the records of the argument types `Args`
+        template <typename... Args>
+        static void print_raw(const FormatState& f, const char* args, const size_t, std::ostream* s) {
+            const FormatState prev = format();
+            format() = f;
+            get().print_raw_to(args, s, RawTypes<Args...>());
+            format() = prev;
+        }
+
+        void print_raw_to(const char*, stream_t* s, RawTypes<>) {
+            println_to(s);
+        }
+
+        template <typename Head, typename... Tail>
+        void print_raw_to(const char* p, stream_t* s, RawTypes<Head, Tail...>) {
+            p = print_raw_one<Head>(p, s, raw_kind<Head>());
+            if (sizeof...(Tail) != 0)
+                print_one(delimiter().str, s);
+            print_raw_to(p, s, RawTypes<Tail...>());
+        }
+
+        template <typename T>
+        const char* print_raw_one(const char* p, stream_t* s, std::integral_constant<RawKind, RawKind::NUMBER>) {
+            T v;
+            memcpy(&v, p, sizeof(v));
+            print_one(v, s);
+            return p + sizeof(v);
+        }
+
+        template <typename T>
+        const char* print_raw_one(const char* p, stream_t* s, std::integral_constant<RawKind, RawKind::TEXT>) {
+            uint32_t n;
+            memcpy(&n, p, sizeof(n));
+            s->write(p + sizeof(n), n);
+            return p + sizeof(n) + n;
+        }
+#endif
+
+        // level tag and "<timestamp> " (no delimiter after them)
+        template <typename S>
+        void print_header(S* s, const char* header, const char* ts, const size_t ts_size) {
+            print_to(s, header);
+            if (ts_size) s->write(ts, ts_size);
+        }
+
+        // "key=value " of the LOG_CONTEXT() scopes of the current thread as is
+        template <typename S>
+        void print_context(S* s) {
+            const Context& c = Context::get();
+            if (c.size) s->write(c.data, c.size);
+        }
+
+        // "<timestamp> " for the header of LOG_XXXX (0 if LogTimestamp::NONE)
+        size_t make_timestamp(char* buf) const {
 #ifdef ARDUINO
-            print_one(head, stream);
-            if (sizeof...(tail) != 0)
-                print_one(delim, stream);
+            size_t n = timestamp::format(buf, ts_kind.load(), ts_digits.load());
 #else
-            print_one(head);
-            if (sizeof...(tail) != 0)
-                print_one(delim);
+            size_t n = timestamp::format(buf, ts_kind.load(), ts_digits.load(), *ts_format.load());
 #endif
-            println(std::forward<Tail>(tail)...);
+            if (n) buf[n++] = ' ';
+            return n;
+        }
+
+        // false if the record is a repeat of the last record on the output (key 0: not coalesced)
+        // "[LEVEL] <timestamp> DebugLog : last message repeated N times" is written by `write` when the repeats end
+        template <typename W>
+        bool coalesce_to(Coalescer& c, const uint64_t key, const char* ts, const size_t ts_size, const W& write) {
+            if (key == 0) return true;
+            const Coalescer::Result r = c.check(key, coalesce_ms.load());
+            write_repeated(r, ts, ts_size, write);
+            return r.b_write;
+        }
+
+        // repeats pending on the output which is not written this time (e.g. filtered by its level)
+        template <typename W>
+        void flush_repeats(Coalescer& c, const bool b_force, const W& write) {
+            char ts[timestamp::BUFFER_SIZE + 1];
+            const Coalescer::Result r = c.take(coalesce_ms.load(), b_force);
+            if (r.n_repeated) write_repeated(r, ts, make_timestamp(ts), write);
+        }
+
+        template <typename W>
+        void write_repeated(const Coalescer::Result& r, const char* ts, const size_t ts_size, const W& write) {
+            if (r.n_repeated == 0) return;
+            char buf[16 + timestamp::BUFFER_SIZE + coalesce::MESSAGE_SIZE];
+            const char* header = generate_header(r.level);
+            size_t n = strlen(header);
+            memcpy(buf, header, n);
+            memcpy(buf + n, ts, ts_size);
+            n += ts_size;
+            n += coalesce::message(buf + n, r.n_repeated);
+            write(buf, n);
         }
 
 #ifdef ARDUINO
-        void print_file() {
-            if (!logger) return;
-            if (b_auto_save) logger->flush();
-            print();
+        // the record is formatted once more to be hashed only if LOG_SET_COALESCE() is enabled
+        template <typename... Args>
+        uint64_t record_key(const LogLevel level, Args&&... args) {
+            coalesce::Hasher h;
+            const FormatState prev = format();
+            print_context(&h);
+            println_to(&h, std::forward<Args>(args)...);
+            format() = prev;
+            return coalesce::make_key(level, h.hash());
         }
+#endif
 
-        template <typename Head, typename... Tail>
-        void print_file(const Head& head, Tail&&... tail) {
-            if (!logger) return;
-            print_one(head, logger);
+        template <typename S, typename Head, typename... Tail>
+        void println_to(S* s, const Head& head, Tail&&... tail) {
+            print_one(head, s);
             if (sizeof...(tail) != 0)
-                print_one(delim, logger);
-            print_file(std::forward<Tail>(tail)...);
+                print_one(delimiter().str, s);
+            println_to(s, std::forward<Tail>(tail)...);
         }
 
-        void println_file() {
-            if (!logger) return;
-            print_one("\n", logger);
-            print_file();
+#ifdef ARDUINO
+        stream_t* begin_record() {
+            return stream;
         }
 
-        template <typename Head, typename... Tail>
-        void println_file(const Head& head, Tail&&... tail) {
-            print_one(head, logger);
-            if (sizeof...(tail) != 0)
-                print_one(delim, logger);
-            println_file(std::forward<Tail>(tail)...);
+        void end_record(stream_t*) {}
+
+        const DropCounter* drop_counter() const {
+            return &drops;
+        }
+
+        // the record is dropped if the stream has less than DEBUGLOG_OVERFLOW_TX_SPACE bytes free
+        // (a record which is longer than the free space still waits for the rest)
+        bool drop_if_full(const LogLevel level) {
+            const OverflowPolicy p = overflow.load();
+            if (p == OverflowPolicy::BLOCK) return false;
+            if (p == OverflowPolicy::DROP_BELOW && (int)level <= (int)overflow_lvl.load()) return false;
+            if (stream->availableForWrite() < DEBUGLOG_OVERFLOW_TX_SPACE) {
+                drops.add(level);
+                return true;
+            }
+            report_drops();
+            return false;
+        }
+
+        // "[WARN] DebugLog : 12 records dropped (INFO 10, TRACE 2)"
+        void report_drops() {
+            uint32_t n[DropCounter::N_LEVELS];
+            const uint32_t sum = drops.take_unreported(n);
+            if (sum == 0) return;
+            stream->print(F("[WARN] DebugLog : "));
+            stream->print((unsigned long)sum);
+            stream->print(F(" records dropped ("));
+            bool b_first = true;
+            for (size_t i = 0; i < DropCounter::N_LEVELS; ++i) {
+                if (n[i] == 0) continue;
+                if (!b_first) stream->print(F(", "));
+                stream->print(DropCounter::label(i));
+                stream->print(' ');
+                stream->print((unsigned long)n[i]);
+                b_first = false;
+            }
+            stream->println(')');
+        }
+#else
+        // one record is formatted into the thread local buffer and written to the sink (or queued) at once
+        // so that records from different threads are not interleaved
+        stream_t* begin_record() {
+            LineStream& ls = line_stream();
+            if (line_stream_busy()) return stream;  // operator<< of the argument logs recursively
+            line_stream_busy() = true;
+            ls.clear_line();
+            return &ls;
+        }
+
+        void end_record(stream_t* s, const bool b_stream = true, MmapFileLogger* file = nullptr, const LogLevel level = LogLevel::LVL_NONE) {
+            if (s == stream) return;
+            const LineStream& ls = static_cast<const LineStream&>(*s);
+            if (b_stream) write_stream(ls.data(), ls.size(), level);
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            if (file) {
+                const uint64_t t0 = stats::now_ns();
+                file->write(ls.data(), ls.size());
+                stats::on_file_write(ls.size(), t0);
+            }
+#else
+            (void)file;
+#endif
+            line_stream_busy() = false;
+        }
+
+        // queued to the async writer if it is running
+        void write_stream(const char* data, const size_t size, const LogLevel level) {
+            AsyncWriter* a = async.load();
+            if (!a || !a->is_running() || !a->push(data, size, level)) {
+                const uint64_t t0 = stats::now_ns();
+                stream->write(data, size);
+                stats::on_stream_write(size, t0);
+            }
+        }
+
+        // written at once to std::cout, the file and all sinks regardless of their levels
+        void write_direct(const LogLevel level, const char* data, const size_t size, const size_t header_size, const size_t time_size) {
+            stream->write(data, (std::streamsize)size);
+#ifdef DEBUGLOG_HAS_MMAP_FILE_LOGGER
+            if (MmapFileLogger* f = logger.load()) f->write(data, size);
+#endif
+            sinks.write(level, data, size, header_size, time_size, false);
+        }
+
+        const DropCounter* drop_counter() const {
+            const AsyncWriter* a = async.load();
+            return a ? &a->dropped() : nullptr;
+        }
+
+        void report_trace_drops() {
+            const uint64_t n = trace::dropped();
+            if (n) log(LogLevel::LVL_WARN, "DebugLog :", n, "trace events dropped (DEBUGLOG_TRACE_MAX_EVENTS per thread, LOG_TRACE_CLEAR() releases them)");
+        }
+
+        void report_stats_if_due() {
+            const uint32_t ms = report_ms.load();
+            const uint32_t now = now_ms();
+            uint32_t next = next_report_ms.load();
+            if ((int32_t)(now - next) < 0) return;
+            if (!next_report_ms.compare_exchange(next, now + ms)) return;  // reported by another thread
+            log(LogLevel::LVL_INFO, "DebugLog stats :", stats().summary());
+        }
+
+        size_t record_size(stream_t* s) const {
+            if (s == stream) return 0;
+            return static_cast<const LineStream&>(*s).size();
+        }
+
+        static LineStream& line_stream() {
+            static thread_local LineStream ls;
+            return ls;
+        }
+
+        static bool& line_stream_busy() {
+            static thread_local bool b {false};
+            return b;
+        }
+
+        static LineStream& raw_stream() {
+            static thread_local LineStream ls;
+            return ls;
+        }
+
+        static LineStream& context_stream() {
+            static thread_local LineStream ls;
+            return ls;
         }
 #endif
 
-    private:
 #ifdef ARDUINO
 
         // print without base and precision
@@ -214,34 +1251,41 @@ namespace debug {
 
         // print with base
         template <typename S>
-        void print_one(const signed char head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const signed char head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const unsigned char head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const unsigned char head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const short head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const short head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const unsigned short head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const unsigned short head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const int head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const int head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const unsigned int head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const unsigned int head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const long head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const long head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
-        void print_one(const unsigned long head, S* s) { s->print(head, (int)log_base); }
+        void print_one(const unsigned long head, S* s) { s->print(head, (int)format().base); }
         template <typename S>
         void print_one(const LogBase& head, S*) {
-            log_base = head;
+            format().base = head;
         }
 
         // print with precision
         template <typename S>
-        void print_one(const float head, S* s) { s->print(head, (int)log_precision); }
+        void print_one(const float head, S* s) { s->print(head, (int)format().precision); }
         template <typename S>
-        void print_one(const double head, S* s) { s->print(head, (int)log_precision); }
+        void print_one(const double head, S* s) { s->print(head, (int)format().precision); }
         template <typename S>
         void print_one(const LogPrecision& head, S*) {
-            log_precision = head;
+            format().precision = head;
+        }
+
+        template <typename S>
+        void print_one(const Suppressed& head, S* s) {
+            s->print(F("(suppressed "));
+            s->print((unsigned long)head.n);
+            s->print(F(" messages)"));
         }
 
         template <typename S, typename T>
@@ -288,114 +1332,315 @@ namespace debug {
         // print one helper
         template <typename S, typename T>
         void print_array(const T& head, S* s) {
-            bool b_base_reset_restore = b_base_reset;
-            b_base_reset = false;
+            const size_t n = n_elements(head.size());
             print_one("[", s);
-            for (size_t i = 0; i < head.size(); ++i) {
+            for (size_t i = 0; i < n; ++i) {
                 print_one(head[i], s);
-                if (i + 1 != head.size())
+                if (i + 1 != n)
                     print_one(", ", s);
             }
+            if (n != head.size()) print_more(", ... (", head.size() - n, " more)", s);
             print_one("]", s);
-            b_base_reset = b_base_reset_restore;
-            if (b_base_reset) log_base = LogBase::DEC;
+            if (b_base_reset.load()) format().base = LogBase::DEC;
         }
 
         template <typename S, typename T>
         void print_map(const T& head, S* s) {
-            bool b_base_reset_restore = b_base_reset;
             print_one("{", s);
-            const size_t size = head.size();
+            const size_t n = n_elements(head.size());
             size_t i = 0;
             for (const auto& kv : head) {
+                if (i == n) break;
                 print_one(kv.first, s);
                 print_one(":", s);
                 print_one(kv.second, s);
-                if (++i != size)
+                if (++i != n)
                     print_one(", ", s);
             }
+            if (n != head.size()) print_more(", ... (", head.size() - n, " more)", s);
             print_one("}", s);
-            b_base_reset = b_base_reset_restore;
-            if (b_base_reset) log_base = LogBase::DEC;
+            if (b_base_reset.load()) format().base = LogBase::DEC;
         }
 
 #else
 
-        template <typename Head>
-        void print_one(const Head& head) {
-            switch (log_base) {
-                case LogBase::DEC: std::cout << std::dec; break;
-                case LogBase::HEX: std::cout << std::hex; break;
-                case LogBase::OCT: std::cout << std::oct; break;
+        template <typename Head, typename S>
+        void print_one(const Head& head, S* s) {
+            switch (format().base) {
+                case LogBase::HEX: *s << std::hex; break;
+                case LogBase::OCT: *s << std::oct; break;
+                default: *s << std::dec; break;
             }
-            std::cout << head;
+            *s << head;
         }
 
-        template <typename T>
-        void print_one(const Array<T>& head) {
-            print_array(head);
+        // numbers are formatted without std::ostream (and its locale) and written at once
+        template <typename S>
+        void print_one(const short head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const unsigned short head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const int head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const unsigned int head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const long head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const unsigned long head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const long long head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const unsigned long long head, S* s) { print_integer(head, s); }
+        template <typename S>
+        void print_one(const float head, S* s) { print_float(head, s); }
+        template <typename S>
+        void print_one(const double head, S* s) { print_float(head, s); }
+        template <typename S>
+        void print_one(const long double head, S* s) { print_float(head, s); }
+
+        template <typename S>
+        void print_one(const LogBase& head, S*) {
+            format().base = head;
         }
 
-        template <typename T>
-        void print_one(const vec_t<T>& head) {
-            print_array(head);
+        template <typename S>
+        void print_one(const LogPrecision& head, S*) {
+            format().precision = (int)head;
         }
 
-        template <typename T>
-        void print_one(const deq_t<T>& head) {
-            print_array(head);
+        template <typename T, typename S>
+        void print_integer(const T head, S* s) {
+            char buf[number::INT_BUFFER_SIZE];
+            char* end = buf + sizeof(buf);
+            const char* p = number::format_int(end, head, format().base);
+            s->write(p, end - p);
         }
 
-        template <typename K, typename V>
-        void print_one(const map_t<K, V>& head) {
-            print_map(head);
+        template <typename T, typename S>
+        void print_float(const T head, S* s) {
+            char buf[number::FLOAT_BUFFER_SIZE];
+            s->write(buf, number::format_float(buf, head, format().precision));
+        }
+
+        template <typename S, typename T>
+        void print_one(const Array<T>& head, S* s) {
+            print_array(head, s);
+        }
+
+        template <typename S, typename T>
+        void print_one(const vec_t<T>& head, S* s) {
+            print_array(head, s);
+        }
+
+        template <typename S, typename T>
+        void print_one(const deq_t<T>& head, S* s) {
+            print_array(head, s);
+        }
+
+        template <typename S, typename K, typename V>
+        void print_one(const map_t<K, V>& head, S* s) {
+            print_map(head, s);
         }
 
         // print one helper
-        template <typename T>
-        void print_array(const T& head) {
-            print_one("[");
-            for (size_t i = 0; i < head.size(); ++i) {
-                print_one(head[i]);
-                if (i + 1 != head.size())
-                    print_one(", ");
+        template <typename S, typename T>
+        void print_array(const T& head, S* s) {
+            const size_t n = n_elements(head.size());
+            print_one("[", s);
+            for (size_t i = 0; i < n; ++i) {
+                print_one(head[i], s);
+                if (i + 1 != n)
+                    print_one(", ", s);
             }
-            print_one("]");
+            if (n != head.size()) print_more(", ... (", head.size() - n, " more)", s);
+            print_one("]", s);
         }
 
-        template <typename T>
-        void print_map(const T& head) {
-            print_one("{");
-            const size_t size = head.size();
+        // contiguous numbers are formatted into the chunk buffer and written block by block
+        template <typename S, typename T>
+        typename std::enable_if<number::is_formatted<T>::value>::type print_array(const Array<T>& head, S* s) {
+            print_numbers(head.ptr, head.size(), s);
+        }
+
+        template <typename S, typename T>
+        typename std::enable_if<number::is_formatted<T>::value>::type print_array(const vec_t<T>& head, S* s) {
+            print_numbers(head.data(), head.size(), s);
+        }
+
+        template <typename S, typename T>
+        void print_numbers(const T* data, const size_t size, S* s) {
+            const size_t n = n_elements(size);
+            const LogBase base = format().base;
+            const int precision = format().precision;
+            char buf[DEBUGLOG_ARRAY_CHUNK_SIZE];
+            size_t len = 0;
+            buf[len++] = '[';
+            for (size_t i = 0; i < n; ++i) {
+                if (len + number::FLOAT_BUFFER_SIZE + 2 > sizeof(buf)) {
+                    s->write(buf, len);
+                    len = 0;
+                }
+                if (i != 0) {
+                    buf[len++] = ',';
+                    buf[len++] = ' ';
+                }
+                len += number::format_number(buf + len, data[i], base, precision);
+            }
+            s->write(buf, len);
+            if (n != size) print_more(", ... (", size - n, " more)", s);
+            print_one("]", s);
+        }
+
+        template <typename S, typename T>
+        void print_map(const T& head, S* s) {
+            print_one("{", s);
+            const size_t n = n_elements(head.size());
             size_t i = 0;
             for (const auto& kv : head) {
-                print_one(kv.first);
-                print_one(":");
-                print_one(kv.second);
-                if (++i != size)
-                    print_one(", ");
+                if (i == n) break;
+                print_one(kv.first, s);
+                print_one(":", s);
+                print_one(kv.second, s);
+                if (++i != n)
+                    print_one(", ", s);
             }
-            print_one("}");
+            if (n != head.size()) print_more(", ... (", head.size() - n, " more)", s);
+            print_one("}", s);
         }
 
 #endif
 
+        template <typename S>
+        void print_one(const HexDump& head, S* s) {
+            static constexpr char digits[] = "0123456789abcdef";
+            const size_t limit = max_dump_bytes.load();
+            const size_t n = (limit && head.sz > limit) ? limit : head.sz;
+            char buf[DEBUGLOG_HEXDUMP_CHUNK_SIZE * 3];
+            size_t len = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (len + 3 > sizeof(buf)) {
+                    s->write(buf, len);
+                    len = 0;
+                }
+                if (i != 0) buf[len++] = ' ';
+                buf[len++] = digits[head.ptr[i] >> 4];
+                buf[len++] = digits[head.ptr[i] & 0xF];
+            }
+            if (len) s->write(buf, len);
+            if (n != head.sz) print_more(" ... (", head.sz - n, " more bytes)", s);
+        }
+
+        size_t n_elements(const size_t size) const {
+            const size_t limit = max_elems.load();
+            return (limit && size > limit) ? limit : size;
+        }
+
+        // "<prefix><rest><suffix>" with rest in decimal regardless of LogBase
+        template <typename S>
+        void print_more(const char* prefix, size_t rest, const char* suffix, S* s) {
+            char buf[24];
+            char* p = buf + sizeof(buf);
+            do {
+                *--p = (char)('0' + rest % 10);
+                rest /= 10;
+            } while (rest);
+            print_one(prefix, s);
+            s->write(p, buf + sizeof(buf) - p);
+            print_one(suffix, s);
+        }
+
+        // preamble rendered at the first use is written at once unless the delimiter is changed after that
+        template <typename S>
+        void print_one(const CallSite& site, S* s) {
+#ifndef ARDUINO
+            const Delimiter& d = delimiter();
+            if (site.delim_id == d.id) {
+                s->write(site.text.data(), site.text.size());
+                return;
+            }
+#else
+            const Delimiter& d = delimiter();
+#endif
+            print_one(site.file, s);
+            print_one(d.str, s);
+            print_one(site.line, s);
+            print_one(d.str, s);
+            print_one(site.func, s);
+            print_one(d.str, s);
+            print_one(":", s);
+        }
+
+        // LOG_XXXXF: literal pieces are written as they are and each argument is printed with its spec
+        template <typename S, size_t M, typename... Args>
+        void print_one(const fmt::Message<M, Args...>& head, S* s) {
+            print_pieces(head.site, 0, head.args, s);
+        }
+
+        template <typename S, size_t M>
+        void print_pieces(const fmt::Site<M>& site, size_t i, const fmt::Refs<>&, S* s) {
+            for (; i < site.size(); ++i) s->write(site[i].str, site[i].size);
+        }
+
+        template <typename S, size_t M, typename Head, typename... Tail>
+        void print_pieces(const fmt::Site<M>& site, size_t i, const fmt::Refs<Head, Tail...>& args, S* s) {
+            for (; site[i].size; ++i) s->write(site[i].str, site[i].size);
+            const fmt::Piece& p = site[i];
+            if (p.spec == '\0') {
+                print_one(args.head, s);
+            } else {
+                const FormatState prev = format();
+                switch (p.spec) {
+                    case 'd': format().base = LogBase::DEC; break;
+                    case 'x': format().base = LogBase::HEX; break;
+                    case 'o': format().base = LogBase::OCT; break;
+                    case 'b': format().base = LogBase::BIN; break;
+#ifdef ARDUINO
+                    default: format().precision = (LogPrecision)p.precision; break;
+#else
+                    default: format().precision = p.precision; break;
+#endif
+                }
+                print_one(args.head, s);
+                format() = prev;
+            }
+            print_pieces(site, i + 1, args.tail, s);
+        }
+
         // ===== other utilities =====
 
-        string_t generate_header(const LogLevel lvl) const {
-            string_t header;
+        const char* generate_header(const LogLevel lvl) const {
             switch (lvl) {
-                case LogLevel::LVL_ERROR: header = "[ERROR] "; break;
-                case LogLevel::LVL_WARN: header = "[WARN] "; break;
-                case LogLevel::LVL_INFO: header = "[INFO] "; break;
-                case LogLevel::LVL_DEBUG: header = "[DEBUG] "; break;
-                case LogLevel::LVL_TRACE: header = "[TRACE] "; break;
-                default: header = ""; break;
+                case LogLevel::LVL_ERROR: return "[ERROR] ";
+                case LogLevel::LVL_WARN: return "[WARN] ";
+                case LogLevel::LVL_INFO: return "[INFO] ";
+                case LogLevel::LVL_DEBUG: return "[DEBUG] ";
+                case LogLevel::LVL_TRACE: return "[TRACE] ";
+                default: return "";
             }
-            return header;
         }
     };
 
+    // LOG_CONTEXT(): "key=value " is rendered once and added to the context of the current thread until the scope exits
+    // scopes must be nested (restored in the reverse order of construction)
+    class ContextScope {
+        size_t prev;
+
+    public:
+        template <typename T>
+        ContextScope(const char* key, const T& value) {
+            Context& c = Context::get();
+            prev = c.size;
+            c.size += Manager::get().render_context(c.data + c.size, sizeof(c.data) - c.size, key, value);
+        }
+
+        ~ContextScope() {
+            Context::get().size = prev;
+        }
+
+        ContextScope(const ContextScope&) = delete;
+        ContextScope& operator=(const ContextScope&) = delete;
+    };
+
 }  // namespace debug
 }  // namespace arx
 
@@ -0,0 +1,253 @@
+#pragma once
+#ifndef DEBUGLOG_MMAP_FILE_LOGGER_H
+#define DEBUGLOG_MMAP_FILE_LOGGER_H
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define DEBUGLOG_HAS_MMAP_FILE_LOGGER
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Sink.h"
+
+#ifndef DEBUGLOG_MMAP_SEGMENT_SIZE
+#define DEBUGLOG_MMAP_SEGMENT_SIZE (4 * 1024 * 1024)
+#endif
+
+#ifndef DEBUGLOG_MMAP_MAX_FILES
+#define DEBUGLOG_MMAP_MAX_FILES 4
+#endif
+
+// interval to open the file again after it failed to be opened (records are dropped meanwhile)
+#ifndef DEBUGLOG_MMAP_RETRY_MS
+#define DEBUGLOG_MMAP_RETRY_MS 1000
+#endif
+
+namespace arx {
+namespace debug {
+
+    // File logger which writes records into a preallocated memory-mapped segment file.
+    // When the segment is full, it is rotated: path -> path.1 -> ... -> path.<max_files - 1>
+    //
+    // Space for a record is reserved with one atomic add, so threads do not lock each other
+    // except when the segment is rotated. The first byte of a record is stored last,
+    // so the content of the file up to the first NUL byte is always a sequence of whole records
+    // even if the process crashes. Closed segments are truncated to their written size.
+    // A record longer than the segment is cut and ends with "...". If the file cannot be opened,
+    // the records are dropped and it is opened again by a later write (reported to stderr).
+    // It can also be added as a sink (e.g. a second file with JsonFormatter).
+    class MmapFileLogger : public Sink {
+        struct Segment {
+            int fd {-1};
+            char* base {nullptr};
+            size_t size {0};
+            std::atomic<size_t> offset {0};
+            std::atomic<size_t> end {0};      // end of written records (the first failed reservation)
+            std::atomic<int> n_writers {0};  // writers which may touch the mapping
+        };
+
+        std::string path;
+        size_t segment_size;
+        size_t max_files;
+
+        Segment segments[2];  // current and previous (being closed) segment
+        std::atomic<Segment*> current {nullptr};
+        std::mutex rotate_mtx;
+        std::atomic<bool> b_closed {false};
+        std::atomic<uint64_t> retry_ms {0};  // the file is opened again after this (ms since the epoch of steady_clock)
+        std::atomic<uint64_t> n_dropped {0};
+        std::atomic<uint64_t> n_truncated {0};
+        uint64_t n_dropped_reported {0};  // rotate_mtx
+
+    public:
+        MmapFileLogger(const std::string& path, const size_t segment_size = DEBUGLOG_MMAP_SEGMENT_SIZE, const size_t max_files = DEBUGLOG_MMAP_MAX_FILES)
+        : path(path), segment_size(segment_size ? segment_size : 1), max_files(max_files ? max_files : 1) {
+            std::lock_guard<std::mutex> lock(rotate_mtx);
+            open_current(segments[0]);
+        }
+
+        ~MmapFileLogger() {
+            close();
+        }
+
+        bool is_open() const {
+            return current.load() != nullptr;
+        }
+
+        // records dropped because the file could not be opened
+        uint64_t dropped() const {
+            return n_dropped.load();
+        }
+
+        // records cut to the segment size
+        uint64_t truncated() const {
+            return n_truncated.load();
+        }
+
+        void write(const char* data, size_t len) override {
+            if (len == 0) return;
+            const bool b_cut = len > segment_size;
+            if (b_cut) {
+                len = segment_size;
+                n_truncated.fetch_add(1);
+            }
+
+            while (true) {
+                Segment* seg = current.load();
+                if (!seg) {
+                    if (reopen()) continue;
+                    if (!b_closed.load()) n_dropped.fetch_add(1);
+                    return;
+                }
+
+                seg->n_writers.fetch_add(1);
+                if (seg != current.load()) {  // rotated or closed in the meantime
+                    seg->n_writers.fetch_sub(1);
+                    continue;
+                }
+
+                const size_t off = seg->offset.fetch_add(len);
+                if (off + len <= seg->size) {
+                    char* p = seg->base + off;
+                    memcpy(p + 1, data + 1, len - 1);
+                    if (b_cut && len > 4) memcpy(p + len - 4, "...\n", 4);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    *(volatile char*)p = data[0];  // the record becomes visible in the file
+                    seg->n_writers.fetch_sub(1);
+                    return;
+                }
+
+                size_t end = seg->end.load();
+                while (off < end && !seg->end.compare_exchange_weak(end, off))
+                    ;
+                seg->n_writers.fetch_sub(1);
+                rotate(seg);
+            }
+        }
+
+        // write dirty pages of the current segment to the disk
+        void flush() override {
+            std::lock_guard<std::mutex> lock(rotate_mtx);
+            Segment* seg = current.load();
+            if (seg) msync(seg->base, seg->size, MS_SYNC);
+        }
+
+        void close() override {
+            std::lock_guard<std::mutex> lock(rotate_mtx);
+            b_closed.store(true);
+            Segment* seg = current.load();
+            if (!seg) return;
+            current.store(nullptr);
+            close_segment(*seg);
+        }
+
+    private:
+        void rotate(Segment* full) {
+            std::lock_guard<std::mutex> lock(rotate_mtx);
+            if (current.load() != full) return;  // already rotated by another thread
+
+            // the mapped file can be renamed while it is open
+            shift_files();
+
+            Segment* next = (full == &segments[0]) ? &segments[1] : &segments[0];
+            if (!open_current(*next)) current.store(nullptr);
+            close_segment(*full);
+        }
+
+        // after open_segment() failed: retried once per DEBUGLOG_MMAP_RETRY_MS by the writers
+        bool reopen() {
+            if (b_closed.load() || now_ms() < retry_ms.load()) return false;
+            std::lock_guard<std::mutex> lock(rotate_mtx);
+            if (current.load()) return true;
+            if (b_closed.load() || now_ms() < retry_ms.load()) return false;
+            return open_current(segments[0]);
+        }
+
+        // with rotate_mtx locked: `seg` becomes the current segment if it is opened
+        bool open_current(Segment& seg) {
+            const int err = open_segment(seg);
+            if (err) {
+                if (retry_ms.load() == 0)
+                    std::fprintf(stderr, "[ERROR] DebugLog : failed to open %s (%s), records are dropped until it is opened\n", path.c_str(), std::strerror(err));
+                retry_ms.store(now_ms() + DEBUGLOG_MMAP_RETRY_MS);
+                return false;
+            }
+            const uint64_t n = n_dropped.load();
+            if (retry_ms.load() != 0)
+                std::fprintf(stderr, "[WARN] DebugLog : %s is opened again (%llu records dropped)\n", path.c_str(), (unsigned long long)(n - n_dropped_reported));
+            n_dropped_reported = n;
+            retry_ms.store(0);
+            current.store(&seg);
+            return true;
+        }
+
+        static uint64_t now_ms() {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // returns errno (0 if opened)
+        int open_segment(Segment& seg) {
+            seg.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (seg.fd < 0) return errno;
+            if (ftruncate(seg.fd, (off_t)segment_size) != 0) {
+                const int err = errno;
+                ::close(seg.fd);
+                seg.fd = -1;
+                return err;
+            }
+            void* p = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, seg.fd, 0);
+            if (p == MAP_FAILED) {
+                const int err = errno;
+                ::close(seg.fd);
+                seg.fd = -1;
+                return err;
+            }
+            seg.base = static_cast<char*>(p);
+            seg.size = segment_size;
+            seg.offset.store(0);
+            seg.end.store(segment_size);
+            return 0;
+        }
+
+        // called after the segment is replaced: waits for the writers and truncates the file
+        void close_segment(Segment& seg) {
+            while (seg.n_writers.load() != 0)
+                std::this_thread::yield();
+            size_t end = seg.end.load();
+            const size_t offset = seg.offset.load();
+            if (offset < end) end = offset;
+            munmap(seg.base, seg.size);
+            if (ftruncate(seg.fd, (off_t)end) != 0) {
+                // keep the preallocated file: content up to the first NUL byte is still valid
+            }
+            ::close(seg.fd);
+            seg.fd = -1;
+            seg.base = nullptr;
+        }
+
+        void shift_files() {
+            if (max_files <= 1) return;  // the current file is truncated by open_segment()
+            for (size_t i = max_files - 1; i > 0; --i) {
+                const std::string from = (i == 1) ? path : path + "." + std::to_string(i - 1);
+                const std::string to = path + "." + std::to_string(i);
+                std::rename(from.c_str(), to.c_str());
+            }
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+
+#endif  // DEBUGLOG_MMAP_FILE_LOGGER_H
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef DEBUGLOG_NUMBER_FORMAT_H
+#define DEBUGLOG_NUMBER_FORMAT_H
+
+#ifndef ARDUINO
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#include "Types.h"
+
+// stack buffer to format arrays of numbers block by block
+#ifndef DEBUGLOG_ARRAY_CHUNK_SIZE
+#define DEBUGLOG_ARRAY_CHUNK_SIZE 4096
+#endif
+
+namespace arx {
+namespace debug {
+namespace number {
+
+    // enough for 64 bit integer in binary and sign
+    static constexpr size_t INT_BUFFER_SIZE {72};
+    static constexpr size_t FLOAT_BUFFER_SIZE {352};
+
+    // "00" "01" ... "99"
+    inline const char* dec_digits() {
+        static constexpr char t[] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+        return t;
+    }
+
+    // "00" "01" ... "ff"
+    inline const char* hex_digits() {
+        static const struct Table {
+            char t[512];
+            Table() {
+                static constexpr char d[] = "0123456789abcdef";
+                for (int i = 0; i < 256; ++i) {
+                    t[i * 2] = d[i >> 4];
+                    t[i * 2 + 1] = d[i & 0xF];
+                }
+            }
+        } table;
+        return table.t;
+    }
+
+    // writes `v` backwards from `end` and returns the first character
+    // two digits (decimal) or one byte (hex) are converted per table lookup
+    inline char* format_uint(char* end, uint64_t v, const LogBase base) {
+        char* p = end;
+        switch (base) {
+            case LogBase::HEX: {
+                const char* t = hex_digits();
+                while (v >= 0x10) {
+                    const char* d = t + (v & 0xFF) * 2;
+                    *--p = d[1];
+                    *--p = d[0];
+                    v >>= 8;
+                }
+                if (v != 0 || p == end) *--p = t[v * 2 + 1];
+                break;
+            }
+            case LogBase::OCT: {
+                do {
+                    *--p = (char)('0' + (v & 7));
+                    v >>= 3;
+                } while (v);
+                break;
+            }
+            case LogBase::BIN: {
+                do {
+                    *--p = (char)('0' + (v & 1));
+                    v >>= 1;
+                } while (v);
+                break;
+            }
+            default: {
+                const char* t = dec_digits();
+                while (v >= 100) {
+                    const char* d = t + (v % 100) * 2;
+                    v /= 100;
+                    *--p = d[1];
+                    *--p = d[0];
+                }
+                if (v >= 10) {
+                    const char* d = t + v * 2;
+                    *--p = d[1];
+                    *--p = d[0];
+                } else {
+                    *--p = (char)('0' + v);
+                }
+                break;
+            }
+        }
+        return p;
+    }
+
+    // negative values are written with '-' in DEC and as two's complement of T in other bases (same as std::ostream)
+    template <typename T>
+    inline char* format_int(char* end, const T v, const LogBase base) {
+        using U = typename std::make_unsigned<T>::type;
+        const U u = (U)v;
+        if (base == LogBase::DEC && std::is_signed<T>::value && (u >> (sizeof(T) * 8 - 1))) {
+            char* p = format_uint(end, (uint64_t)(U)(U(0) - u), base);
+            *--p = '-';
+            return p;
+        }
+        return format_uint(end, (uint64_t)u, base);
+    }
+
+    // length written by snprintf (truncated at the end of the buffer)
+    inline size_t clamp(const int n) {
+        if (n < 0) return 0;
+        return ((size_t)n < FLOAT_BUFFER_SIZE) ? (size_t)n : FLOAT_BUFFER_SIZE - 1;
+    }
+
+    // `precision` < 0 : 6 significant digits (same as std::ostream)
+    // `precision` >= 0 : fixed point with `precision` digits (same as Print::print(double, digits) on Arduino)
+    // returns the number of characters
+    template <typename T>
+    inline size_t format_float(char* buf, const T v, const int precision) {
+        if (precision < 0) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            // same digits as printf("%g") but locale independent and much faster
+            const std::to_chars_result r = std::to_chars(buf, buf + FLOAT_BUFFER_SIZE, v, std::chars_format::general, 6);
+            if (r.ec == std::errc()) return (size_t)(r.ptr - buf);
+#endif
+            return clamp(snprintf(buf, FLOAT_BUFFER_SIZE, "%Lg", (long double)v));
+        }
+
+        static constexpr double pow10[] {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+        const double d = (double)v;
+        if (precision > 8 || !std::isfinite(d) || std::fabs(d) >= 1e10)
+            return clamp(snprintf(buf, FLOAT_BUFFER_SIZE, "%.*Lf", precision, (long double)v));
+
+        // round half up at the last digit and split into integer and fraction (same as Arduino)
+        const bool negative = d < 0.0;
+        const uint64_t scaled = (uint64_t)(std::fabs(d) * pow10[precision] + 0.5);
+        const uint64_t p10 = (uint64_t)pow10[precision];
+        char* end = buf + FLOAT_BUFFER_SIZE;
+        char* p = end;
+        if (precision > 0) {
+            uint64_t frac = scaled % p10;
+            for (int i = 0; i < precision; ++i) {
+                *--p = (char)('0' + frac % 10);
+                frac /= 10;
+            }
+            *--p = '.';
+        }
+        p = format_uint(p, scaled / p10, LogBase::DEC);
+        if (negative) *--p = '-';
+        const size_t n = (size_t)(end - p);
+        memmove(buf, p, n);
+        return n;
+    }
+
+    // numbers which are formatted by this engine (characters and bool are printed by std::ostream)
+    template <typename T, typename U = typename std::remove_cv<T>::type>
+    struct is_formatted
+    : std::integral_constant<bool,
+          (std::is_integral<U>::value && !std::is_same<U, bool>::value && !std::is_same<U, char>::value
+              && !std::is_same<U, signed char>::value && !std::is_same<U, unsigned char>::value)
+              || std::is_floating_point<U>::value> {};
+
+    // writes one number at `dst` which has at least FLOAT_BUFFER_SIZE bytes and returns the length
+    template <typename T>
+    inline typename std::enable_if<std::is_integral<T>::value, size_t>::type
+    format_number(char* dst, const T v, const LogBase base, const int) {
+        char buf[INT_BUFFER_SIZE];
+        char* end = buf + sizeof(buf);
+        const char* p = format_int(end, v, base);
+        memcpy(dst, p, (size_t)(end - p));
+        return (size_t)(end - p);
+    }
+
+    template <typename T>
+    inline typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+    format_number(char* dst, const T v, const LogBase, const int precision) {
+        return format_float(dst, v, precision);
+    }
+
+}  // namespace number
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_NUMBER_FORMAT_H
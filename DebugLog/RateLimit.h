@@ -0,0 +1,99 @@
+#pragma once
+#ifndef DEBUGLOG_RATE_LIMIT_H
+#define DEBUGLOG_RATE_LIMIT_H
+
+#include "Types.h"
+
+#ifndef ARDUINO
+#include <chrono>
+#include <ostream>
+#endif
+
+namespace arx {
+namespace debug {
+
+    // milliseconds since the first call (wraps around after 49 days)
+    inline uint32_t now_ms() {
+#ifdef ARDUINO
+        return millis();
+#else
+        static const auto t0 = std::chrono::steady_clock::now();
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+#endif
+    }
+
+    // number of messages which were dropped by the rate limiter since the last output
+    struct Suppressed {
+        uint32_t n;
+    };
+
+#ifndef ARDUINO
+    inline std::ostream& operator<<(std::ostream& os, const Suppressed& s) {
+        return os << "(suppressed " << std::dec << s.n << " messages)";
+    }
+#endif
+
+    // state of one rate limited call site, created once by LOG_RATE_LIMITER()
+    // every check returns 0 if the message is suppressed,
+    // otherwise 1 + the number of messages suppressed since the last output
+    class RateLimiter {
+        RelaxedAtomic<uint32_t> n_calls {0};
+        RelaxedAtomic<uint32_t> n_suppressed {0};
+        RelaxedAtomic<uint32_t> next_ms {0};
+        RelaxedAtomic<uint64_t> bucket {0};  // last refill time (upper 32 bits) and milli-tokens (lower 32 bits)
+
+    public:
+        uint32_t every_n(const uint32_t n) {
+            if (n_calls.fetch_add(1) % (n ? n : 1) != 0) return suppress();
+            return pass();
+        }
+
+        uint32_t first_n(const uint32_t n) {
+            if (n_calls.load() >= n) return suppress();
+            if (n_calls.fetch_add(1) >= n) return suppress();
+            return pass();
+        }
+
+        uint32_t every_ms(const uint32_t ms) {
+            const uint32_t now = now_ms();
+            uint32_t next = next_ms.load();
+            if ((int32_t)(now - next) < 0) return suppress();
+            if (!next_ms.compare_exchange(next, now + ms)) return suppress();  // another thread passed
+            return pass();
+        }
+
+        // token bucket: `per_sec` messages per second on average and `burst` messages at once
+        uint32_t rate(const uint32_t per_sec, const uint32_t burst) {
+            const uint32_t now = now_ms();
+            const uint64_t capacity = (uint64_t)(burst ? burst : 1) * 1000;
+            uint64_t state = bucket.load();
+            while (true) {
+                uint64_t tokens = capacity;  // the bucket is full at the first call
+                if (state != 0) {
+                    const uint32_t last = (uint32_t)(state >> 32);
+                    tokens = (state & 0xFFFFFFFF) + (uint64_t)(uint32_t)(now - last) * per_sec;
+                    if (tokens > capacity) tokens = capacity;
+                }
+                const bool b_pass = tokens >= 1000;
+                if (b_pass) tokens -= 1000;
+                const uint64_t desired = ((uint64_t)now << 32) | tokens | 1;  // never 0 after the first call
+                if (bucket.compare_exchange(state, desired)) return b_pass ? pass() : suppress();
+            }
+        }
+
+    private:
+        uint32_t suppress() {
+            n_suppressed.fetch_add(1);
+            return 0;
+        }
+
+        uint32_t pass() {
+            const uint32_t n = n_suppressed.exchange(0);
+            return (n == 0xFFFFFFFF) ? n : n + 1;
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_RATE_LIMIT_H
@@ -0,0 +1,331 @@
+#pragma once
+#ifndef DEBUGLOG_SHM_RING_H
+#define DEBUGLOG_SHM_RING_H
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define DEBUGLOG_HAS_SHM_RING
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "Sink.h"
+
+// size of the shared memory of ShmRingSink (rounded down to a power of 2 slots)
+#ifndef DEBUGLOG_SHM_RING_SIZE
+#define DEBUGLOG_SHM_RING_SIZE (1024 * 1024)
+#endif
+
+// a record longer than one slot takes consecutive slots
+#ifndef DEBUGLOG_SHM_RING_SLOT_SIZE
+#define DEBUGLOG_SHM_RING_SLOT_SIZE 256
+#endif
+
+namespace arx {
+namespace debug {
+namespace shm_ring {
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "atomics in the shared memory must be lock-free");
+
+    static constexpr char MAGIC[8] = {'D', 'L', 'S', 'H', 'M', 'R', 'N', 'G'};
+    static constexpr uint32_t VERSION {1};
+    static constexpr uint32_t READY {2};
+
+    // beginning of the shared memory, followed by n_slots slots of slot_size bytes
+    // every field is read and written by several processes, so the layout must not be changed without VERSION
+    struct Header {
+        char magic[8];
+        std::atomic<uint32_t> state;  // 0: not initialized, 1: initializing, READY
+        uint32_t version;
+        uint32_t slot_size;
+        uint32_t n_slots;    // power of 2
+        uint32_t owner_pid;  // 0 if shared by processes
+        uint32_t reserved;
+        alignas(64) std::atomic<uint64_t> head;  // next ticket reserved by producers
+        alignas(64) std::atomic<uint64_t> tail;  // next ticket read by the collector
+        std::atomic<uint64_t> dropped;           // records dropped because the ring was full
+    };
+
+    static constexpr size_t HEADER_SIZE {256};
+    static_assert(sizeof(Header) <= HEADER_SIZE, "shm_ring::Header is too large");
+
+    // header of one slot (the payload follows)
+    struct Slot {
+        std::atomic<uint64_t> seq;  // ticket + 1 after the slot is written
+        uint64_t time_ns;           // std::chrono::system_clock when the record was written
+        uint32_t pid;
+        uint32_t size;   // bytes of the payload in this slot
+        uint16_t index;  // index of this slot in the record
+        uint16_t count;  // number of slots of the record
+        uint32_t reserved;
+    };
+
+    static constexpr size_t MIN_SLOT_SIZE {64};
+
+    inline uint64_t now_ns() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // POSIX shared memory names begin with '/'
+    inline std::string shm_name(const std::string& name) {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+    // lock-free multi-producer ring in POSIX shared memory
+    // producers reserve slots with one CAS and never wait for the collector (the record is dropped if the ring is full),
+    // and the slots are committed one by one, so records written before a producer crashes stay in the memory
+    class Ring {
+        std::string nm;
+        int fd {-1};
+        char* base {nullptr};
+        size_t map_size {0};
+        // collector: the ticket which has not been committed since `stall_since`
+        uint64_t stall_ticket {~0ull};
+        uint64_t stall_since {0};
+
+    public:
+        Ring() {}
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        ~Ring() {
+            close();
+        }
+
+        // producer: creates the shared memory, or attaches to it if `b_exclusive` is false and it already exists
+        bool create(const std::string& name, const size_t bytes, size_t slot_size, const uint32_t owner_pid, const bool b_exclusive) {
+            close();
+            nm = shm_name(name);
+            fd = shm_open(nm.c_str(), O_RDWR | O_CREAT | (b_exclusive ? O_EXCL : 0), 0644);
+            if (fd < 0) return false;
+            slot_size = (slot_size < MIN_SLOT_SIZE) ? MIN_SLOT_SIZE : (slot_size + 7) & ~(size_t)7;
+            size_t n_slots = 2;
+            while (HEADER_SIZE + n_slots * 2 * slot_size <= bytes) n_slots *= 2;
+            struct stat st;
+            if (fstat(fd, &st) != 0) return fail();
+            if (st.st_size == 0 && ftruncate(fd, (off_t)(HEADER_SIZE + n_slots * slot_size)) != 0) return fail();
+            if (!map()) return fail();
+
+            // the first process initializes the header and the others wait for it
+            Header& h = header();
+            uint32_t s = 0;
+            if (h.state.compare_exchange_strong(s, 1)) {
+                memcpy(h.magic, MAGIC, sizeof(MAGIC));
+                h.version = VERSION;
+                h.slot_size = (uint32_t)slot_size;
+                h.n_slots = (uint32_t)n_slots;
+                h.owner_pid = owner_pid;
+                h.state.store(READY, std::memory_order_release);
+            }
+            return wait_ready() ? true : fail();
+        }
+
+        // collector: attaches to the shared memory created by producers
+        bool open(const std::string& name) {
+            close();
+            nm = shm_name(name);
+            fd = shm_open(nm.c_str(), O_RDWR, 0);
+            if (fd < 0) return false;
+            return (map() && wait_ready()) ? true : fail();
+        }
+
+        void close() {
+            if (base) munmap(base, map_size);
+            if (fd >= 0) ::close(fd);
+            base = nullptr;
+            fd = -1;
+        }
+
+        bool is_open() const {
+            return base != nullptr;
+        }
+
+        const std::string& name() const {
+            return nm;
+        }
+
+        Header& header() const {
+            return *reinterpret_cast<Header*>(base);
+        }
+
+        // records which are not read by the collector yet
+        bool empty() const {
+            const Header& h = header();
+            return h.head.load(std::memory_order_acquire) == h.tail.load(std::memory_order_acquire);
+        }
+
+        // producer: never blocks, false if the record is dropped because the ring is full
+        bool push(const char* data, const size_t size, const uint64_t time_ns, const uint32_t pid) {
+            if (!base || size == 0) return false;
+            Header& h = header();
+            const size_t payload = h.slot_size - sizeof(Slot);
+            const uint64_t count = (size + payload - 1) / payload;
+            uint64_t ticket = h.head.load(std::memory_order_relaxed);
+            do {
+                if (count > h.n_slots || ticket + count - h.tail.load(std::memory_order_acquire) > h.n_slots) {
+                    h.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (!h.head.compare_exchange_weak(ticket, ticket + count, std::memory_order_relaxed));
+
+            for (uint64_t i = 0; i < count; ++i) {
+                Slot& s = slot(ticket + i);
+                const size_t n = (i + 1 == count) ? size - i * payload : payload;
+                s.time_ns = time_ns;
+                s.pid = pid;
+                s.size = (uint32_t)n;
+                s.index = (uint16_t)i;
+                s.count = (uint16_t)count;
+                memcpy(reinterpret_cast<char*>(&s) + sizeof(Slot), data + i * payload, n);
+                s.seq.store(ticket + i + 1, std::memory_order_release);
+            }
+            return true;
+        }
+
+        // collector: f(time_ns, pid, data, size) for the committed records in the order of reservation
+        // a slot which is reserved but not committed for `stall_ns` is skipped (its producer crashed or stalled)
+        // returns the number of slots skipped
+        template <typename F>
+        size_t drain(F&& f, const uint64_t stall_ns, std::string& buf) {
+            Header& h = header();
+            size_t n_skipped = 0;
+            uint64_t tail = h.tail.load(std::memory_order_relaxed);
+            while (tail != h.head.load(std::memory_order_acquire)) {
+                const Slot& first = slot(tail);
+                uint64_t count = 0;
+                if (is_committed(first, tail)) {
+                    if (first.index != 0) {  // rest of a record whose first slot was skipped
+                        h.tail.store(++tail, std::memory_order_release);
+                        ++n_skipped;
+                        continue;
+                    }
+                    count = first.count;
+                    for (uint64_t i = 1; i < count; ++i)
+                        if (!is_committed(slot(tail + i), tail + i)) count = 0;
+                }
+                if (count == 0) {
+                    if (!is_stalled(tail, stall_ns)) break;
+                    // the number of slots is unknown until the first slot is committed
+                    const uint64_t n = is_committed(first, tail) ? first.count : 1;
+                    tail += n;
+                    n_skipped += (size_t)n;
+                    h.tail.store(tail, std::memory_order_release);
+                    continue;
+                }
+                buf.clear();
+                for (uint64_t i = 0; i < count; ++i) {
+                    const Slot& s = slot(tail + i);
+                    buf.append(reinterpret_cast<const char*>(&s) + sizeof(Slot), s.size);
+                }
+                tail += count;
+                h.tail.store(tail, std::memory_order_release);  // the slots can be reused by producers
+                f(first.time_ns, first.pid, buf.data(), buf.size());
+            }
+            return n_skipped;
+        }
+
+    private:
+        bool fail() {
+            close();
+            return false;
+        }
+
+        bool map() {
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE) return false;
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) return false;
+            base = static_cast<char*>(p);
+            map_size = (size_t)st.st_size;
+            return true;
+        }
+
+        bool wait_ready() {
+            const Header& h = header();
+            for (int i = 0; i < 1000 && h.state.load(std::memory_order_acquire) != READY; ++i)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return h.state.load(std::memory_order_acquire) == READY
+                && memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+                && h.version == VERSION
+                && h.slot_size >= MIN_SLOT_SIZE
+                && h.n_slots != 0 && (h.n_slots & (h.n_slots - 1)) == 0
+                && HEADER_SIZE + (size_t)h.n_slots * h.slot_size <= map_size;
+        }
+
+        Slot& slot(const uint64_t ticket) const {
+            const Header& h = header();
+            return *reinterpret_cast<Slot*>(base + HEADER_SIZE + (size_t)(ticket & (h.n_slots - 1)) * h.slot_size);
+        }
+
+        static bool is_committed(const Slot& s, const uint64_t ticket) {
+            return s.seq.load(std::memory_order_acquire) == ticket + 1;
+        }
+
+        bool is_stalled(const uint64_t ticket, const uint64_t stall_ns) {
+            const uint64_t now = now_ns();
+            if (ticket != stall_ticket) {
+                stall_ticket = ticket;
+                stall_since = now;
+            }
+            return now - stall_since >= stall_ns;
+        }
+    };
+
+}  // namespace shm_ring
+
+    enum class ShmRingMode {
+        PER_PROCESS,  // "<name>.<pid>" is created for each process
+        SHARED,       // all processes write to "<name>" without lock
+    };
+
+    // writes records into a ring in POSIX shared memory drained by tools/shm_log_collector
+    // write() never blocks on the collector: records are dropped while the ring is full
+    class ShmRingSink : public Sink {
+        shm_ring::Ring ring;
+        uint32_t pid;
+
+    public:
+        explicit ShmRingSink(const std::string& name, const ShmRingMode mode = ShmRingMode::PER_PROCESS, const size_t bytes = DEBUGLOG_SHM_RING_SIZE, const size_t slot_size = DEBUGLOG_SHM_RING_SLOT_SIZE)
+        : pid((uint32_t)getpid()) {
+            if (mode == ShmRingMode::SHARED) {
+                ring.create(name, bytes, slot_size, 0, false);
+                return;
+            }
+            // the ring of a previous process with the same pid is kept until it is drained
+            const std::string base = name + "." + std::to_string(pid);
+            for (int i = 0; i < 16 && !ring.is_open(); ++i)
+                ring.create(i ? base + "-" + std::to_string(i) : base, bytes, slot_size, pid, true);
+        }
+
+        bool is_open() const {
+            return ring.is_open();
+        }
+
+        // name of the shared memory ("/<name>.<pid>" for ShmRingMode::PER_PROCESS)
+        const std::string& name() const {
+            return ring.name();
+        }
+
+        // records dropped because the ring was full (by all processes if shared)
+        uint64_t dropped() const {
+            return ring.is_open() ? ring.header().dropped.load(std::memory_order_relaxed) : 0;
+        }
+
+        void write(const char* data, const size_t size) override {
+            ring.push(data, size, shm_ring::now_ns(), pid);
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+
+#endif  // DEBUGLOG_SHM_RING_H
@@ -0,0 +1,159 @@
+#pragma once
+#ifndef DEBUGLOG_SINK_H
+#define DEBUGLOG_SINK_H
+
+#ifndef ARDUINO
+
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "Types.h"
+
+namespace arx {
+namespace debug {
+
+    // output of LOG_XXXX records registered by LOG_ADD_SINK()
+    // write() always receives one or more whole records
+    // and is called from the logging threads concurrently unless the sink has its own queue
+    // close() is called by LOG_REMOVE_SINK() after the last write() (records written after close() are discarded)
+    class Sink {
+    public:
+        virtual ~Sink() {}
+        virtual void write(const char* data, const size_t size) = 0;
+        virtual void flush() {}
+        virtual void close() { flush(); }
+    };
+
+    // std::ostream (e.g. std::cerr) as a sink
+    // the stream must outlive the sink (remove it by LOG_REMOVE_SINK() before the stream is destroyed)
+    class OstreamSink : public Sink {
+        std::ostream& os;
+
+    protected:
+        std::mutex mtx;
+
+    public:
+        explicit OstreamSink(std::ostream& os)
+        : os(os) {}
+
+        void write(const char* data, const size_t size) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            os.write(data, (std::streamsize)size);
+        }
+
+        void flush() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            os.flush();
+        }
+    };
+
+    // the file is constructed before OstreamSink
+    struct FileStreamHolder {
+        std::ofstream ofs;
+
+        explicit FileStreamHolder(const std::string& path)
+        : ofs(path, std::ios::binary | std::ios::trunc) {}
+    };
+
+    // file which is owned by the sink
+    class FileSink : private FileStreamHolder, public OstreamSink {
+    public:
+        explicit FileSink(const std::string& path)
+        : FileStreamHolder(path), OstreamSink(ofs) {}
+
+        bool is_open() const { return ofs.is_open(); }
+
+        void close() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            ofs.close();
+        }
+    };
+
+    // one LOG_XXXX record passed to Formatter
+    struct Record {
+        LogLevel level;
+        const char* header;  // level tag and timestamp ("[INFO] " or "[INFO] 12.345678 ")
+        size_t header_size;
+        const char* body;  // preamble and arguments terminated by '\n'
+        size_t body_size;
+        const char* time;  // timestamp in the header (LOG_SET_TIMESTAMP())
+        size_t time_size;
+    };
+
+    // converts the text record for sinks
+    // the record is formatted once per formatter instance and shared by sinks which use the same instance
+    class Formatter {
+    public:
+        virtual ~Formatter() {}
+        virtual void format(const Record& r, std::string& out) const = 0;
+    };
+
+    inline const char* level_name(const LogLevel lvl) {
+        switch (lvl) {
+            case LogLevel::LVL_ERROR: return "ERROR";
+            case LogLevel::LVL_WARN: return "WARN";
+            case LogLevel::LVL_INFO: return "INFO";
+            case LogLevel::LVL_DEBUG: return "DEBUG";
+            case LogLevel::LVL_TRACE: return "TRACE";
+            default: return "NONE";
+        }
+    }
+
+    // record without the level tag and the timestamp
+    class PlainFormatter : public Formatter {
+    public:
+        void format(const Record& r, std::string& out) const override {
+            out.append(r.body, r.body_size);
+        }
+    };
+
+    // appends `size` bytes of `str` escaped for a JSON string (without quotes)
+    inline void append_json_escaped(std::string& out, const char* str, const size_t size) {
+        static constexpr char digits[] = "0123456789abcdef";
+        for (size_t i = 0; i < size; ++i) {
+            const unsigned char c = (unsigned char)str[i];
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        out += "\\u00";
+                        out += digits[c >> 4];
+                        out += digits[c & 0xF];
+                    } else {
+                        out += (char)c;
+                    }
+                    break;
+            }
+        }
+    }
+
+    // one JSON object per line: {"level":"INFO","message":"..."} ("time" is added by LOG_SET_TIMESTAMP())
+    class JsonFormatter : public Formatter {
+    public:
+        void format(const Record& r, std::string& out) const override {
+            out += "{\"level\":\"";
+            out += level_name(r.level);
+            if (r.time_size) {
+                out += "\",\"time\":\"";
+                append_json_escaped(out, r.time, r.time_size);
+            }
+            out += "\",\"message\":\"";
+            size_t n = r.body_size;
+            if (n && r.body[n - 1] == '\n') --n;
+            append_json_escaped(out, r.body, n);
+            out += "\"}\n";
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_SINK_H
@@ -0,0 +1,299 @@
+#pragma once
+#ifndef DEBUGLOG_SINK_REGISTRY_H
+#define DEBUGLOG_SINK_REGISTRY_H
+
+#ifndef ARDUINO
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Types.h"
+#include "Sink.h"
+#include "AsyncWriter.h"
+#include "Stats.h"
+#include "Coalesce.h"
+
+namespace arx {
+namespace debug {
+
+    // Sinks added by LOG_ADD_SINK() in addition to std::cout and LOG_ATTACH_FILE().
+    // The list is replaced on every change and read lock-free on the log path.
+    // A removed sink is closed and released after the threads writing to it have finished.
+    // A sink with queue_bytes > 0 has its own ring and writer thread, so a slow sink
+    // never blocks the logging thread nor other sinks (OverflowPolicy::DROP_NEWEST by default).
+    class SinkRegistry {
+        struct Entry {
+            uint32_t id;
+            std::shared_ptr<Sink> sink;
+            std::shared_ptr<Formatter> formatter;
+            RelaxedAtomic<LogLevel> level;
+            std::unique_ptr<AsyncWriter> worker;
+            Coalescer repeats;
+
+            Entry(const uint32_t id, const std::shared_ptr<Sink>& sink, const std::shared_ptr<Formatter>& formatter, const LogLevel level)
+            : id(id), sink(sink), formatter(formatter), level(level) {}
+
+            // written directly if the writer thread of the queue has been stopped
+            // remove() / clear() stop it after the other threads have left the list, so this is only
+            // the thread which called them while writing (e.g. LOG_REMOVE_SINK() from a Formatter)
+            void write(const char* data, const size_t size, const LogLevel level) {
+                if (worker && worker->push(data, size, level)) return;
+                const uint64_t t0 = stats::now_ns();
+                sink->write(data, size);
+                stats::on_sink_write(size, t0);
+            }
+        };
+
+        struct List {
+            std::vector<std::shared_ptr<Entry>> entries;
+        };
+
+        // records formatted by each formatter for the current record
+        struct FormatCache {
+            std::vector<std::pair<const Formatter*, std::string>> items;
+            size_t n {0};
+
+            const std::string& get(const Formatter* f, const Record& r) {
+                for (size_t i = 0; i < n; ++i)
+                    if (items[i].first == f) return items[i].second;
+                if (n == items.size()) items.emplace_back();
+                std::pair<const Formatter*, std::string>& item = items[n++];
+                item.first = f;
+                item.second.clear();
+                f->format(r, item.second);
+                return item.second;
+            }
+        };
+
+        SharedSnapshot<List> list;
+        RelaxedAtomic<LogLevel> max_lvl {LogLevel::LVL_NONE};
+        uint32_t next_id {0};
+        std::mutex mtx;
+
+    public:
+        SinkRegistry() {
+            list.store(new List());
+        }
+
+        ~SinkRegistry() {
+            clear();
+        }
+
+        // highest level of all sinks (LVL_NONE if there is no sink)
+        LogLevel max_level() const {
+            return max_lvl.load();
+        }
+
+        uint32_t add(const std::shared_ptr<Sink>& sink, const LogLevel level, const std::shared_ptr<Formatter>& formatter, const size_t queue_bytes) {
+            if (!sink) return 0;
+            std::lock_guard<std::mutex> lock(mtx);
+            std::shared_ptr<Entry> e = std::make_shared<Entry>(++next_id, sink, formatter, level);
+            if (queue_bytes) {
+                e->worker.reset(new AsyncWriter(sink.get(), queue_bytes, formatter));
+                e->worker->overflow_policy(OverflowPolicy::DROP_NEWEST);
+            }
+            List* next = new List(*list.load());
+            next->entries.push_back(e);
+            update(next);
+            return e->id;
+        }
+
+        // queued records are written and the sink is closed (unless it is also added with another id) before this returns
+        // this waits for the threads writing to the sinks, so it must not be called while holding a lock which a sink takes
+        // (other sinks can be added and removed meanwhile)
+        bool remove(const uint32_t id) {
+            std::vector<std::shared_ptr<Entry>> removed;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                List* next = new List(*list.load());
+                for (auto it = next->entries.begin(); it != next->entries.end(); ++it) {
+                    if ((*it)->id != id) continue;
+                    removed.push_back(*it);
+                    next->entries.erase(it);
+                    break;
+                }
+                if (removed.empty()) {
+                    delete next;
+                    return false;
+                }
+                update(next);
+            }
+            stop(removed);
+            return true;
+        }
+
+        void clear() {
+            std::vector<std::shared_ptr<Entry>> removed;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                removed = list.load()->entries;
+                update(new List());
+            }
+            stop(removed);
+        }
+
+        LogLevel level(const uint32_t id) const {
+            const SnapshotGuard guard;
+            const Entry* e = find(id);
+            return e ? e->level.load() : LogLevel::LVL_NONE;
+        }
+
+        void level(const uint32_t id, const LogLevel l) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Entry* e = find(id);
+            if (!e) return;
+            e->level.store(l);
+            update_level(*list.load());
+        }
+
+        // only for sinks which have a queue
+        void overflow_policy(const uint32_t id, const OverflowPolicy p, const LogLevel level) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Entry* e = find(id);
+            if (e && e->worker) e->worker->overflow_policy(p, level);
+        }
+
+        // records dropped by OverflowPolicy because the queue of the sink was full
+        uint32_t dropped(const uint32_t id, const LogLevel level) const {
+            const SnapshotGuard guard;
+            const Entry* e = find(id);
+            return (e && e->worker) ? e->worker->dropped().count(level) : 0;
+        }
+
+        uint32_t dropped(const uint32_t id) const {
+            const SnapshotGuard guard;
+            const Entry* e = find(id);
+            return (e && e->worker) ? e->worker->dropped().count() : 0;
+        }
+
+        // dropped records of all sinks
+        uint64_t dropped() const {
+            const SnapshotGuard guard;
+            uint64_t n = 0;
+            for (const auto& e : list.load()->entries)
+                if (e->worker) n += e->worker->dropped().count();
+            return n;
+        }
+
+        // waits for queued records and flushes all sinks (with the repeats not reported yet)
+        void flush() {
+            const SnapshotGuard guard;
+            const List* l = list.load();
+            const Record r {LogLevel::LVL_NONE, "", 0, "", 0, "", 0};
+            for (const auto& e : l->entries) {
+                write_repeated(*e, e->repeats.take(0, true), r);
+                if (e->worker) e->worker->flush();
+                e->sink->flush();
+                stats::on_flush();
+            }
+        }
+
+        // `data` is the text record which has `header_size` bytes of header ("[INFO] " or "[INFO] <time> ") at the beginning
+        // and the timestamp of `time_size` bytes is followed by a space at the end of the header
+        // the level of each sink is ignored if `b_filter` is false (e.g. flight recorder dump)
+        // the repeats of the record are coalesced for each sink if `key` is not 0 (LOG_SET_COALESCE())
+        void write(const LogLevel level, const char* data, const size_t size, const size_t header_size, const size_t time_size = 0, const bool b_filter = true, const uint64_t key = 0, const uint32_t interval_ms = 0) {
+            const SnapshotGuard guard;
+            const List* l = list.load();
+            const char* time = time_size ? data + header_size - time_size - 1 : data + header_size;
+            const Record r {level, data, header_size, data + header_size, size - header_size, time, time_size};
+            FormatCache& cache = format_cache();
+            cache.n = 0;
+            for (const auto& e : l->entries) {
+                if (b_filter && (int)level > (int)e->level.load()) {
+                    if (key) write_repeated(*e, e->repeats.take(interval_ms, false), r);
+                    continue;
+                }
+                if (key) {
+                    const Coalescer::Result c = e->repeats.check(key, interval_ms);
+                    write_repeated(*e, c, r);
+                    if (!c.b_write) continue;
+                }
+                if (!e->formatter) {
+                    e->write(data, size, level);
+                    continue;
+                }
+                const std::string& out = cache.get(e->formatter.get(), r);
+                e->write(out.data(), out.size(), level);
+            }
+        }
+
+    private:
+        Entry* find(const uint32_t id) const {
+            for (const auto& e : list.load()->entries)
+                if (e->id == id) return e.get();
+            return nullptr;
+        }
+
+        void update(List* next) {
+            list.store(next);
+            update_level(*next);
+        }
+
+        void update_level(const List& l) {
+            LogLevel lvl = LogLevel::LVL_NONE;
+            for (const auto& e : l.entries)
+                if ((int)e->level.load() > (int)lvl) lvl = e->level.load();
+            max_lvl.store(lvl);
+        }
+
+        // "[LEVEL] <time> DebugLog : last message repeated N times" with the time of the current record
+        static void write_repeated(Entry& e, const Coalescer::Result& c, const Record& r) {
+            if (c.n_repeated == 0) return;
+            char msg[coalesce::MESSAGE_SIZE];
+            const size_t msg_size = coalesce::message(msg, c.n_repeated);
+            std::string line;
+            line.append("[").append(level_name(c.level)).append("] ");
+            if (r.time_size) line.append(r.time, r.time_size).append(" ");
+            const size_t header_size = line.size();
+            line.append(msg, msg_size);
+            const char* time = r.time_size ? line.data() + header_size - r.time_size - 1 : line.data() + header_size;
+            const Record rep {c.level, line.data(), header_size, line.data() + header_size, msg_size, time, r.time_size};
+            if (!e.formatter) {
+                e.write(line.data(), line.size(), c.level);
+                return;
+            }
+            std::string out;
+            e.formatter->format(rep, out);
+            e.write(out.data(), out.size(), c.level);
+        }
+
+        static bool has_sink(const List& l, const Sink* sink) {
+            for (const auto& e : l.entries)
+                if (e->sink.get() == sink) return true;
+            return false;
+        }
+
+        // mtx is not held while waiting: a thread which a sink is waiting for may call add() or remove()
+        void stop(const std::vector<std::shared_ptr<Entry>>& removed) {
+            list.synchronize();  // no thread writes to the removed entries any more
+            std::vector<bool> b_close;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                for (const auto& e : removed) b_close.push_back(!has_sink(*list.load(), e->sink.get()));
+            }
+            for (size_t i = 0; i < removed.size(); ++i) {
+                Entry& e = *removed[i];
+                if (e.worker) e.worker->stop();
+                if (b_close[i])
+                    e.sink->close();
+                else
+                    e.sink->flush();
+            }
+        }
+
+        static FormatCache& format_cache() {
+            static thread_local FormatCache cache;
+            return cache;
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_SINK_REGISTRY_H
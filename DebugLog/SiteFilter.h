@@ -0,0 +1,213 @@
+#pragma once
+#ifndef DEBUGLOG_SITE_FILTER_H
+#define DEBUGLOG_SITE_FILTER_H
+
+#include "Types.h"
+#include "CallSite.h"
+
+namespace arx {
+namespace debug {
+
+    // level of the record and whether its call site is forced on by LOG_SET_SITE_LEVEL()
+    struct SiteLevel {
+        LogLevel level;
+        bool b_forced;
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+// every LOG_XXXX call site is registered to the site table and can be enabled / disabled at runtime
+// (always on C++, and on Arduino only if DEBUGLOG_ENABLE_SITE_FILTER is defined because each site takes RAM)
+#if !defined(ARDUINO) || defined(DEBUGLOG_ENABLE_SITE_FILTER)
+#define DEBUGLOG_HAS_SITE_FILTER
+
+#ifndef ARDUINO
+#include <mutex>
+#include <vector>
+#endif
+
+// max number of patterns kept by LOG_SET_SITE_LEVEL() on Arduino
+#ifndef DEBUGLOG_MAX_SITE_RULES
+#define DEBUGLOG_MAX_SITE_RULES 4
+#endif
+
+namespace arx {
+namespace debug {
+
+    // state of one LOG_XXXX call site in static storage
+    // it is zero-initialized (no guard on the log path) and registered at the first check
+    struct FilterSite {
+        enum State : uint8_t {
+            UNREGISTERED = 0,
+            DEFAULT,  // filtered by the levels of the outputs
+            ON,       // written regardless of LOG_SET_LEVEL() (the file and sinks keep their levels)
+            OFF,      // not written to any output
+        };
+
+        RelaxedAtomic<uint8_t> state;
+        LogLevel level;
+        int line;
+        const char* file;  // short filename
+        const char* func;
+        FilterSite* next;
+    };
+
+    // FNV-1a of the first `n` characters of `s` (up to '\0')
+    constexpr uint64_t site_hash(const char* s, const uint64_t h, const size_t n) {
+        return (n == 0 || *s == '\0') ? h : site_hash(s + 1, (h ^ (uint8_t)*s) * 1099511628211ull, n - 1);
+    }
+
+    // FNV-1a of __FILE__ to make the slot of the call site at compile time
+    // hashed by chunks, so long paths do not exceed the constexpr depth limit
+    constexpr uint64_t site_hash(const char* s, const uint64_t h = 14695981039346656037ull) {
+        return has_nul(s, CONSTEXPR_CHUNK) ? site_hash(s, h, CONSTEXPR_CHUNK) : site_hash(s + CONSTEXPR_CHUNK, site_hash(s, h, CONSTEXPR_CHUNK));
+    }
+
+    // one FilterSite per file, line and level (shared by the check and the record of LOG_XXXX)
+    // call sites with the same level on the same line share the state
+    template <uint64_t File, int Line, LogLevel Level>
+    struct SiteSlot {
+        static FilterSite site;
+
+        // the only check of a disabled site on the log path
+        static bool is_off() {
+            return site.state.load() == FilterSite::OFF;
+        }
+
+        static SiteLevel level() {
+            return SiteLevel {Level, site.state.load() == FilterSite::ON};
+        }
+    };
+
+    template <uint64_t File, int Line, LogLevel Level>
+    FilterSite SiteSlot<File, Line, Level>::site;
+
+    // registered call sites and the patterns applied to them in order
+    // "file:<name>", "func:<name>" and "line:<n>" separated by spaces must all match the site ("*" is a wildcard)
+    // e.g. "file:Motor.h", "func:update*", "file:main.cpp line:42", "*"
+    class SiteFilter {
+        struct Rule {
+            string_t pattern;
+            LogLevel level;
+        };
+
+        FilterSite* head {nullptr};
+#ifdef ARDUINO
+        Rule rules[DEBUGLOG_MAX_SITE_RULES];
+        size_t n_rules {0};
+#else
+        std::vector<Rule> rules;
+        mutable std::mutex mtx;
+#endif
+
+    public:
+        // called once per call site at its first check
+        void add(FilterSite& site, const LogLevel level, const char* file, const int line, const char* func) {
+#ifndef ARDUINO
+            std::lock_guard<std::mutex> lock(mtx);
+#endif
+            if (site.state.load() != FilterSite::UNREGISTERED) return;  // registered by another thread
+            site.level = level;
+            site.line = line;
+            site.file = short_filename(file);
+            site.func = func;
+            site.next = head;
+            head = &site;
+            site.state.store(state_of(site));
+        }
+
+        // sites matching `pattern` are written up to `level` regardless of LOG_SET_LEVEL() and disabled above it
+        // false if the pattern cannot be kept (DEBUGLOG_MAX_SITE_RULES on Arduino)
+        bool set(const string_t& pattern, const LogLevel level) {
+#ifdef ARDUINO
+            if (n_rules == DEBUGLOG_MAX_SITE_RULES) return false;
+            rules[n_rules++] = Rule {pattern, level};
+#else
+            std::lock_guard<std::mutex> lock(mtx);
+            rules.push_back(Rule {pattern, level});
+#endif
+            for (FilterSite* s = head; s; s = s->next)
+                if (matches(pattern.c_str(), *s)) s->state.store(state_of(*s, level));
+            return true;
+        }
+
+        // all sites are filtered only by the levels of the outputs again
+        void reset() {
+#ifdef ARDUINO
+            n_rules = 0;
+#else
+            std::lock_guard<std::mutex> lock(mtx);
+            rules.clear();
+#endif
+            for (FilterSite* s = head; s; s = s->next) s->state.store(FilterSite::DEFAULT);
+        }
+
+        template <typename F>
+        void for_each(F&& f) const {
+#ifndef ARDUINO
+            std::lock_guard<std::mutex> lock(mtx);
+#endif
+            for (const FilterSite* s = head; s; s = s->next) f(*s);
+        }
+
+    private:
+        uint8_t state_of(const FilterSite& s) const {
+            uint8_t state = FilterSite::DEFAULT;
+#ifdef ARDUINO
+            const Rule* const end = rules + n_rules;
+            for (const Rule* r = rules; r != end; ++r)
+#else
+            for (auto r = rules.begin(); r != rules.end(); ++r)
+#endif
+                if (matches(r->pattern.c_str(), s)) state = state_of(s, r->level);
+            return state;
+        }
+
+        static uint8_t state_of(const FilterSite& s, const LogLevel level) {
+            return ((int)s.level <= (int)level) ? FilterSite::ON : FilterSite::OFF;
+        }
+
+        static bool matches(const char* p, const FilterSite& s) {
+            while (*p == ' ') ++p;
+            if (*p == '\0') return true;
+            const char* end = p;
+            while (*end != '\0' && *end != ' ') ++end;
+            bool b_match = false;
+            if (starts_with(p, "file:"))
+                b_match = glob(p + 5, end, s.file);
+            else if (starts_with(p, "func:"))
+                b_match = glob(p + 5, end, s.func);
+            else if (starts_with(p, "line:"))
+                b_match = (end != p + 5) && (parse_int(p + 5, end) == s.line);
+            else
+                b_match = glob(p, end, "");
+            return b_match && matches(end, s);
+        }
+
+        static bool starts_with(const char* s, const char* prefix) {
+            return strncmp(s, prefix, strlen(prefix)) == 0;
+        }
+
+        static bool glob(const char* p, const char* end, const char* s) {
+            if (p == end) return *s == '\0';
+            if (*p == '*') return glob(p + 1, end, s) || (*s != '\0' && glob(p, end, s + 1));
+            return *s == *p && glob(p + 1, end, s + 1);
+        }
+
+        static int parse_int(const char* p, const char* end) {
+            int n = 0;
+            for (; p != end; ++p) {
+                if (*p < '0' || *p > '9') return -1;
+                n = n * 10 + (*p - '0');
+            }
+            return n;
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // !ARDUINO || DEBUGLOG_ENABLE_SITE_FILTER
+
+#endif  // DEBUGLOG_SITE_FILTER_H
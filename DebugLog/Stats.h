@@ -0,0 +1,273 @@
+#pragma once
+#ifndef DEBUGLOG_STATS_H
+#define DEBUGLOG_STATS_H
+
+#ifndef ARDUINO
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+namespace arx {
+namespace debug {
+namespace stats {
+
+    // log-linear buckets (HDR histogram style): 8 sub-buckets per power of two, about 12.5% resolution
+    static constexpr size_t SUB_BITS {3};
+    static constexpr size_t SUB_COUNT {1 << SUB_BITS};
+    static constexpr size_t MAX_EXPONENT {40};  // values are clamped to 2^41 - 1 ns (about 36 minutes)
+    static constexpr size_t N_BUCKETS {(MAX_EXPONENT - SUB_BITS + 2) * SUB_COUNT};
+    static constexpr size_t N_LEVELS {(size_t)LogLevel::LVL_TRACE + 1};
+
+    inline size_t bucket_index(uint64_t v) {
+        if (v < SUB_COUNT) return (size_t)v;
+        size_t e = 63;
+        while (!(v >> e)) --e;
+        if (e > MAX_EXPONENT) {
+            e = MAX_EXPONENT;
+            v = (uint64_t(1) << (MAX_EXPONENT + 1)) - 1;
+        }
+        const size_t sub = (size_t)(v >> (e - SUB_BITS)) & (SUB_COUNT - 1);
+        return (e - SUB_BITS + 1) * SUB_COUNT + sub;
+    }
+
+    // highest value which is counted in the bucket
+    inline uint64_t bucket_upper(const size_t i) {
+        if (i < SUB_COUNT) return i;
+        const size_t e = i / SUB_COUNT + SUB_BITS - 1;
+        const uint64_t lower = (uint64_t)(SUB_COUNT + i % SUB_COUNT) << (e - SUB_BITS);
+        return lower + (uint64_t(1) << (e - SUB_BITS)) - 1;
+    }
+
+    // written only by the owner thread and read by StatsSnapshot::collect()
+    class Counter {
+        std::atomic<uint64_t> v {0};
+
+    public:
+        void add(const uint64_t n) { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        uint64_t load() const { return v.load(std::memory_order_relaxed); }
+    };
+
+    class Histogram {
+        Counter buckets[N_BUCKETS];
+        Counter sum;
+        std::atomic<uint64_t> max {0};
+
+    public:
+        void record(const uint64_t v) {
+            buckets[bucket_index(v)].add(1);
+            sum.add(v);
+            if (v > max.load(std::memory_order_relaxed)) max.store(v, std::memory_order_relaxed);
+        }
+
+        friend struct HistogramSnapshot;
+    };
+
+    // merged histogram of all threads (values in nanoseconds)
+    struct HistogramSnapshot {
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(N_BUCKETS);
+        uint64_t count {0};
+        uint64_t sum {0};
+        uint64_t max {0};
+
+        void merge(const Histogram& h) {
+            for (size_t i = 0; i < N_BUCKETS; ++i) {
+                const uint64_t n = h.buckets[i].load();
+                buckets[i] += n;
+                count += n;
+            }
+            sum += h.sum.load();
+            const uint64_t m = h.max.load(std::memory_order_relaxed);
+            if (m > max) max = m;
+        }
+
+        uint64_t mean() const {
+            return count ? sum / count : 0;
+        }
+
+        // upper bound of the bucket which contains the `p` (0.0 - 1.0) quantile
+        uint64_t percentile(const double p) const {
+            if (count == 0) return 0;
+            uint64_t rank = (uint64_t)(p * (double)count + 0.5);
+            if (rank < 1) rank = 1;
+            if (rank > count) rank = count;
+            uint64_t n = 0;
+            for (size_t i = 0; i < N_BUCKETS; ++i) {
+                n += buckets[i];
+                if (n >= rank) return (bucket_upper(i) < max) ? bucket_upper(i) : max;
+            }
+            return max;
+        }
+    };
+
+    // counters of one thread (padded so that threads do not share cache lines)
+    struct ThreadStats {
+        char pad0[64];
+        Counter records[N_LEVELS];  // LOG_XXXX records formatted per level
+        Counter filtered;           // log() calls dropped by the runtime log levels
+        Counter stream_bytes;       // bytes written to std::cout (also by the async writer)
+        Counter file_bytes;         // bytes written to LOG_ATTACH_FILE
+        Counter sink_bytes;         // bytes written to LOG_ADD_SINK sinks
+        Counter flushes;            // flushes of the async writer, files and sinks
+        Histogram log_ns;           // duration of log()
+        Histogram write_ns;         // duration of one write to std::cout, the file or a sink
+        char pad1[64];
+    };
+
+    // blocks of all threads: a block is reused by a new thread after its thread exits
+    class Registry {
+        std::mutex mtx;
+        std::vector<std::unique_ptr<ThreadStats>> blocks;
+        std::vector<ThreadStats*> free_blocks;
+
+    public:
+        // never destroyed: writer threads may exit after static objects are destroyed
+        static Registry& get() {
+            static Registry* r = new Registry();
+            return *r;
+        }
+
+        ThreadStats* acquire() {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!free_blocks.empty()) {
+                ThreadStats* t = free_blocks.back();
+                free_blocks.pop_back();
+                return t;
+            }
+            blocks.emplace_back(new ThreadStats());
+            return blocks.back().get();
+        }
+
+        void release(ThreadStats* t) {
+            std::lock_guard<std::mutex> lock(mtx);
+            free_blocks.push_back(t);
+        }
+
+        template <typename F>
+        void for_each(F&& f) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto& b : blocks) f(*b);
+        }
+    };
+
+    inline ThreadStats& local() {
+        struct Owner {
+            ThreadStats* t;
+            Owner()
+            : t(Registry::get().acquire()) {}
+            ~Owner() { Registry::get().release(t); }
+        };
+        static thread_local Owner owner;
+        return *owner.t;
+    }
+
+    // hooks on the log path: they are empty and optimized out unless DEBUGLOG_ENABLE_STATS is defined
+#ifdef DEBUGLOG_ENABLE_STATS
+    inline uint64_t now_ns() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    inline void on_filtered() { local().filtered.add(1); }
+    inline void on_record(const LogLevel level, const uint64_t t0) {
+        ThreadStats& t = local();
+        t.records[(size_t)level].add(1);
+        t.log_ns.record(now_ns() - t0);
+    }
+    inline void on_stream_write(const size_t n, const uint64_t t0) {
+        ThreadStats& t = local();
+        t.stream_bytes.add(n);
+        t.write_ns.record(now_ns() - t0);
+    }
+    inline void on_file_write(const size_t n, const uint64_t t0) {
+        ThreadStats& t = local();
+        t.file_bytes.add(n);
+        t.write_ns.record(now_ns() - t0);
+    }
+    inline void on_sink_write(const size_t n, const uint64_t t0) {
+        ThreadStats& t = local();
+        t.sink_bytes.add(n);
+        t.write_ns.record(now_ns() - t0);
+    }
+    inline void on_flush() { local().flushes.add(1); }
+#else
+    inline uint64_t now_ns() { return 0; }
+    inline void on_filtered() {}
+    inline void on_record(const LogLevel, const uint64_t) {}
+    inline void on_stream_write(const size_t, const uint64_t) {}
+    inline void on_file_write(const size_t, const uint64_t) {}
+    inline void on_sink_write(const size_t, const uint64_t) {}
+    inline void on_flush() {}
+#endif
+
+}  // namespace stats
+
+    // sum of the counters of all threads returned by LOG_GET_STATS()
+    struct StatsSnapshot {
+        uint64_t records[stats::N_LEVELS] {};  // index: LogLevel
+        uint64_t filtered {0};
+        uint64_t dropped {0};  // by OverflowPolicy (async queue and sinks)
+        uint64_t stream_bytes {0};
+        uint64_t file_bytes {0};
+        uint64_t sink_bytes {0};
+        uint64_t flushes {0};
+        stats::HistogramSnapshot log_ns;
+        stats::HistogramSnapshot write_ns;
+
+        uint64_t total_records() const {
+            uint64_t n = 0;
+            for (size_t i = 0; i < stats::N_LEVELS; ++i) n += records[i];
+            return n;
+        }
+
+        // "records 12 (ERROR 1, INFO 11), filtered 3, dropped 0, ... log p50/p99/max 250/1023/4000 ns, ..."
+        std::string summary() const {
+            static constexpr const char* names[] {"PRINT", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+            std::string str = "records " + std::to_string(total_records()) + " (";
+            bool b_first = true;
+            for (size_t i = 0; i < stats::N_LEVELS; ++i) {
+                if (records[i] == 0) continue;
+                if (!b_first) str += ", ";
+                str += std::string(names[i]) + " " + std::to_string(records[i]);
+                b_first = false;
+            }
+            str += "), filtered " + std::to_string(filtered);
+            str += ", dropped " + std::to_string(dropped);
+            str += ", bytes " + std::to_string(stream_bytes + file_bytes + sink_bytes);
+            str += ", flushes " + std::to_string(flushes);
+            str += ", log p50/p99/max " + latency(log_ns);
+            str += ", write p50/p99/max " + latency(write_ns);
+            return str;
+        }
+
+        static StatsSnapshot collect() {
+            StatsSnapshot s;
+            stats::Registry::get().for_each([&s](const stats::ThreadStats& t) {
+                for (size_t i = 0; i < stats::N_LEVELS; ++i) s.records[i] += t.records[i].load();
+                s.filtered += t.filtered.load();
+                s.stream_bytes += t.stream_bytes.load();
+                s.file_bytes += t.file_bytes.load();
+                s.sink_bytes += t.sink_bytes.load();
+                s.flushes += t.flushes.load();
+                s.log_ns.merge(t.log_ns);
+                s.write_ns.merge(t.write_ns);
+            });
+            return s;
+        }
+
+    private:
+        static std::string latency(const stats::HistogramSnapshot& h) {
+            return std::to_string(h.percentile(0.5)) + "/" + std::to_string(h.percentile(0.99)) + "/" + std::to_string(h.max) + " ns";
+        }
+    };
+
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_STATS_H
@@ -0,0 +1,189 @@
+#pragma once
+#ifndef DEBUGLOG_TIMESTAMP_H
+#define DEBUGLOG_TIMESTAMP_H
+
+#ifndef ARDUINO
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <time.h>
+#endif
+
+#include "Types.h"
+
+// LOG_XXXX header timestamp until LOG_SET_TIMESTAMP() is called
+#if defined(DEBUGLOG_DEFAULT_TIMESTAMP_UPTIME)
+#define DEBUGLOG_DEFAULT_TIMESTAMP LogTimestamp::UPTIME
+#elif defined(DEBUGLOG_DEFAULT_TIMESTAMP_LOCAL)
+#define DEBUGLOG_DEFAULT_TIMESTAMP LogTimestamp::LOCAL
+#elif defined(DEBUGLOG_DEFAULT_TIMESTAMP_UTC)
+#define DEBUGLOG_DEFAULT_TIMESTAMP LogTimestamp::UTC
+#else
+#define DEBUGLOG_DEFAULT_TIMESTAMP LogTimestamp::NONE
+#endif
+
+// digits of the fraction of a second (0, 3, 6 or 9)
+#ifndef DEBUGLOG_DEFAULT_TIMESTAMP_DIGITS
+#define DEBUGLOG_DEFAULT_TIMESTAMP_DIGITS 6
+#endif
+
+// strftime() format of the date and time of LOG_SET_TIMESTAMP(LOCAL / UTC) (C++)
+#ifndef DEBUGLOG_DEFAULT_TIMESTAMP_FORMAT
+#define DEBUGLOG_DEFAULT_TIMESTAMP_FORMAT "%Y-%m-%d %H:%M:%S"
+#endif
+
+namespace arx {
+namespace debug {
+namespace timestamp {
+
+    // date and time formatted by strftime() and the fraction of a second
+    static constexpr size_t DATE_SIZE {64};
+    static constexpr size_t BUFFER_SIZE {DATE_SIZE + 16};
+
+    // "<int>.<frac>" without the fraction if `digits` is 0 (frac has 9 digits)
+    inline size_t append_fraction(char* buf, size_t n, uint32_t frac_ns, const uint8_t digits) {
+        if (digits == 0) return n;
+        buf[n++] = '.';
+        char d[9];
+        for (int i = 8; i >= 0; --i) {
+            d[i] = (char)('0' + frac_ns % 10);
+            frac_ns /= 10;
+        }
+        for (uint8_t i = 0; i < digits; ++i) buf[n++] = d[i];
+        return n;
+    }
+
+    inline size_t append_uint(char* buf, size_t n, uint64_t v) {
+        char d[20];
+        size_t i = 0;
+        do {
+            d[i++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (i) buf[n++] = d[--i];
+        return n;
+    }
+
+    inline uint8_t valid_digits(const uint8_t digits) {
+        if (digits >= 9) return 9;
+        if (digits >= 6) return 6;
+        if (digits >= 3) return 3;
+        return 0;
+    }
+
+#ifdef ARDUINO
+
+    // micros() extended to 64 bit (called at least once per 71 minutes by LOG_XXXX to detect the wraparound)
+    inline uint64_t uptime_us() {
+        static uint32_t hi {0};
+        static uint32_t last {0};
+        const uint32_t now = micros();
+        if (now < last) ++hi;
+        last = now;
+        return ((uint64_t)hi << 32) | now;
+    }
+
+    // "<seconds since boot>.<fraction>" (LOCAL and UTC are the same as UPTIME because there is no RTC)
+    inline size_t format(char* buf, const LogTimestamp kind, const uint8_t digits) {
+        if (kind == LogTimestamp::NONE) return 0;
+        const uint64_t us = uptime_us();
+        const size_t n = append_uint(buf, 0, us / 1000000);
+        const uint8_t d = valid_digits(digits);
+        return append_fraction(buf, n, (uint32_t)(us % 1000000) * 1000, (d > 6) ? 6 : d);
+    }
+
+#else
+
+    // strftime() format which is replaced as a whole (id is changed every time)
+    struct Format {
+        std::string str;
+        uint32_t id;
+    };
+
+    // monotonic clock of the timestamp
+    // CLOCK_MONOTONIC_COARSE is a few times cheaper but only as precise as the timer tick (1 - 4 ms)
+    inline uint64_t monotonic_ns() {
+#if defined(DEBUGLOG_TIMESTAMP_COARSE_CLOCK) && defined(CLOCK_MONOTONIC_COARSE)
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // reference of LogTimestamp::UPTIME (set when Manager is created)
+    inline uint64_t start_ns() {
+        static const uint64_t t0 = monotonic_ns();
+        return t0;
+    }
+
+    // wall clock is derived from the monotonic clock and its offset to system_clock
+    // the offset and the date text are updated only when the second changes
+    struct DateCache {
+        int64_t offset_ns {0};
+        int64_t sec {INT64_MIN};
+        uint32_t format_id {UINT32_MAX};
+        LogTimestamp kind {LogTimestamp::NONE};
+        char text[DATE_SIZE];
+        size_t size {0};
+    };
+
+    inline DateCache& date_cache() {
+        static thread_local DateCache cache;
+        return cache;
+    }
+
+    inline int64_t system_ns() {
+        return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    inline size_t format(char* buf, const LogTimestamp kind, const uint8_t digits, const Format& fmt) {
+        if (kind == LogTimestamp::NONE) return 0;
+        const uint64_t t0 = start_ns();
+        const uint64_t mono = monotonic_ns();
+        const uint8_t d = valid_digits(digits);
+        if (kind == LogTimestamp::UPTIME) {
+            const uint64_t ns = mono - t0;
+            const size_t n = append_uint(buf, 0, ns / 1000000000ull);
+            return append_fraction(buf, n, (uint32_t)(ns % 1000000000ull), d);
+        }
+
+        DateCache& c = date_cache();
+        int64_t ns = (int64_t)mono + c.offset_ns;
+        int64_t sec = (ns >= 0) ? ns / 1000000000ll : (ns - 999999999ll) / 1000000000ll;
+        if (sec != c.sec || c.format_id != fmt.id || c.kind != kind) {
+            c.offset_ns = system_ns() - (int64_t)mono;
+            ns = (int64_t)mono + c.offset_ns;
+            sec = (ns >= 0) ? ns / 1000000000ll : (ns - 999999999ll) / 1000000000ll;
+            const time_t t = (time_t)sec;
+            struct tm tm;
+#ifdef _WIN32
+            if (kind == LogTimestamp::UTC)
+                gmtime_s(&tm, &t);
+            else
+                localtime_s(&tm, &t);
+#else
+            if (kind == LogTimestamp::UTC)
+                gmtime_r(&t, &tm);
+            else
+                localtime_r(&t, &tm);
+#endif
+            c.size = strftime(c.text, sizeof(c.text), fmt.str.c_str(), &tm);
+            c.sec = sec;
+            c.format_id = fmt.id;
+            c.kind = kind;
+        }
+        memcpy(buf, c.text, c.size);
+        return append_fraction(buf, c.size, (uint32_t)(ns - sec * 1000000000ll), d);
+    }
+
+#endif  // ARDUINO
+
+}  // namespace timestamp
+}  // namespace debug
+}  // namespace arx
+
+#endif  // DEBUGLOG_TIMESTAMP_H
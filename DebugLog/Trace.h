@@ -0,0 +1,376 @@
+#pragma once
+#ifndef DEBUGLOG_TRACE_H
+#define DEBUGLOG_TRACE_H
+
+#ifndef ARDUINO
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "Sink.h"
+#include "NumberFormat.h"
+
+// events kept per thread for LOG_TRACE_EXPORT() (further events of the thread are dropped until LOG_TRACE_CLEAR())
+#ifndef DEBUGLOG_TRACE_MAX_EVENTS
+#define DEBUGLOG_TRACE_MAX_EVENTS 262144
+#endif
+
+namespace arx {
+namespace debug {
+namespace trace {
+
+    // static descriptor of one LOG_SCOPE / LOG_TRACE_BEGIN / LOG_TRACE_END call site
+    struct Site {
+        const char* name;
+        const char* file;
+        int line;
+        const char* func;
+    };
+
+    struct Event {
+        const Site* site;
+        uint64_t ts;   // ns since the first event of the process
+        uint64_t dur;  // ns (only for 'X')
+        char ph;       // 'X' : LOG_SCOPE, 'B' : LOG_TRACE_BEGIN, 'E' : LOG_TRACE_END
+    };
+
+    inline uint64_t now_ns() {
+        static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    // events of one thread: appended only by the owner thread and read by export_json() at any time
+    // memory is allocated in chunks as the events grow, and a published event is never moved
+    // clear() is done by the owner thread at its next event, or at once if no thread owns the buffer
+    class Buffer {
+        static constexpr size_t CHUNK_EVENTS {1024};
+        static constexpr size_t N_CHUNKS {(DEBUGLOG_TRACE_MAX_EVENTS + CHUNK_EVENTS - 1) / CHUNK_EVENTS};
+        static constexpr uint32_t CLEAR {1};     // requested by clear()
+        static constexpr uint32_t CLEARING {2};  // the events are being released
+        static constexpr uint32_t READER {4};    // added while export_json() reads the events
+
+        std::atomic<Event*> chunks[N_CHUNKS];
+        std::atomic<size_t> n {0};
+        std::atomic<uint64_t> n_dropped {0};
+        std::atomic<uint32_t> state {0};
+        size_t n_exported {0};  // events read by the last for_each()
+
+        friend class Registry;
+        // guarded by the mutex of Registry
+        uint32_t id;
+        bool b_owned {true};  // false after the owner thread exits
+
+    public:
+        explicit Buffer(const uint32_t tid)
+        : id(tid) {
+            for (auto& c : chunks) c.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~Buffer() {
+            for (auto& c : chunks) delete[] c.load(std::memory_order_relaxed);
+        }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        uint32_t tid() const {
+            return id;
+        }
+
+        void push(const Site* site, const uint64_t ts, const uint64_t dur, const char ph) {
+            if (state.load(std::memory_order_relaxed) & CLEAR) release_events();
+            const size_t i = n.load(std::memory_order_relaxed);
+            const size_t c = i / CHUNK_EVENTS;
+            if (c >= N_CHUNKS) {
+                n_dropped.store(n_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            Event* chunk = chunks[c].load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = new Event[CHUNK_EVENTS];
+                chunks[c].store(chunk, std::memory_order_relaxed);
+            }
+            chunk[i % CHUNK_EVENTS] = Event {site, ts, dur, ph};
+            n.store(i + 1, std::memory_order_release);
+        }
+
+        uint64_t dropped() const {
+            return n_dropped.load(std::memory_order_relaxed);
+        }
+
+        // the events are no longer exported, and are released by release_events()
+        void clear() {
+            state.fetch_or(CLEAR, std::memory_order_relaxed);
+        }
+
+        // by the owner thread (or any thread if no thread owns the buffer) after clear()
+        // the first chunk is kept for the next events, and this is postponed while export_json() reads the events
+        void release_events() {
+            uint32_t s = CLEAR;
+            if (!state.compare_exchange_strong(s, CLEARING, std::memory_order_acquire, std::memory_order_relaxed)) return;
+            for (size_t c = 1; c < N_CHUNKS; ++c) {
+                delete[] chunks[c].load(std::memory_order_relaxed);
+                chunks[c].store(nullptr, std::memory_order_relaxed);
+            }
+            n.store(0, std::memory_order_relaxed);
+            n_dropped.store(0, std::memory_order_relaxed);
+            n_exported = 0;
+            state.store(0, std::memory_order_release);
+        }
+
+        template <typename F>
+        void for_each(F&& f) {
+            uint32_t s = state.load(std::memory_order_relaxed);
+            do {
+                if (s & (CLEAR | CLEARING)) return;
+            } while (!state.compare_exchange_weak(s, s + READER, std::memory_order_acquire, std::memory_order_relaxed));
+            const size_t size = n.load(std::memory_order_acquire);
+            for (size_t i = 0; i < size; ++i)
+                f(chunks[i / CHUNK_EVENTS].load(std::memory_order_relaxed)[i % CHUNK_EVENTS]);
+            n_exported = size;
+            state.fetch_sub(READER, std::memory_order_release);
+        }
+
+        // all events have been exported (or cleared)
+        bool is_exported() const {
+            return n.load(std::memory_order_acquire) == n_exported;
+        }
+    };
+
+    // buffers of all threads: kept after the thread exits so that its events can be exported,
+    // and reused by a new thread once they have been exported or cleared
+    class Registry {
+        std::mutex mtx;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        uint32_t n_threads {0};
+
+    public:
+        // never destroyed: threads may exit after static objects are destroyed
+        static Registry& get() {
+            static Registry* r = new Registry();
+            return *r;
+        }
+
+        Buffer* acquire() {
+            std::lock_guard<std::mutex> lock(mtx);
+            const uint32_t tid = ++n_threads;
+            for (const auto& b : buffers) {
+                if (b->b_owned || !b->is_exported()) continue;
+                b->clear();
+                b->release_events();
+                b->id = tid;
+                b->b_owned = true;
+                return b.get();
+            }
+            buffers.emplace_back(new Buffer(tid));
+            return buffers.back().get();
+        }
+
+        // by the thread_local destructor of the owner thread
+        void release(Buffer* b) {
+            std::lock_guard<std::mutex> lock(mtx);
+            b->release_events();
+            b->b_owned = false;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto& b : buffers) {
+                b->clear();
+                if (!b->b_owned) b->release_events();
+            }
+        }
+
+        // events dropped since the buffers were cleared
+        uint64_t dropped() {
+            std::lock_guard<std::mutex> lock(mtx);
+            uint64_t sum = 0;
+            for (const auto& b : buffers) sum += b->dropped();
+            return sum;
+        }
+
+        template <typename F>
+        void for_each(F&& f) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto& b : buffers) f(*b);
+        }
+    };
+
+    struct ThreadState {
+        Buffer* buffer;  // nullptr until the first event (and after the thread exits)
+        bool b_exited;
+    };
+
+    // trivial, so it is still usable from other thread_local destructors
+    inline ThreadState& thread_state() {
+        static thread_local ThreadState s {nullptr, false};
+        return s;
+    }
+
+    // returns the buffer to the registry when the thread exits
+    struct ThreadExit {
+        ~ThreadExit() {
+            ThreadState& s = thread_state();
+            s.b_exited = true;
+            if (!s.buffer) return;
+            Registry::get().release(s.buffer);
+            s.buffer = nullptr;
+        }
+    };
+
+    // nullptr once the thread is exiting (the events are dropped)
+    inline Buffer* local() {
+        ThreadState& s = thread_state();
+        if (!s.buffer && !s.b_exited) {
+            s.buffer = Registry::get().acquire();
+            static thread_local ThreadExit exit;
+            (void)exit;
+        }
+        return s.buffer;
+    }
+
+    inline void push(const Site& site, const uint64_t ts, const uint64_t dur, const char ph) {
+        if (Buffer* b = local()) b->push(&site, ts, dur, ph);
+    }
+
+    // events of all threads are no longer exported and their memory is released
+    inline void clear() {
+        Registry::get().clear();
+    }
+
+    inline uint64_t dropped() {
+        return Registry::get().dropped();
+    }
+
+    // LOG_SCOPE: one complete event is recorded when the scope exits
+    class Scope {
+        const Site& site;
+        const uint64_t t0;
+
+    public:
+        explicit Scope(const Site& site)
+        : site(site), t0(now_ns()) {}
+
+        ~Scope() {
+            const uint64_t t1 = now_ns();
+            push(site, t0, t1 - t0, 'X');
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    inline void begin(const Site& site) {
+        push(site, now_ns(), 0, 'B');
+    }
+
+    inline void end(const Site& site) {
+        push(site, now_ns(), 0, 'E');
+    }
+
+    // nanoseconds as microseconds with three decimals ("12.345")
+    inline void append_us(std::string& out, const uint64_t ns) {
+        char buf[number::INT_BUFFER_SIZE];
+        char* end = buf + sizeof(buf);
+        const uint64_t frac = ns % 1000;
+        char* p = end;
+        *--p = (char)('0' + frac % 10);
+        *--p = (char)('0' + frac / 10 % 10);
+        *--p = (char)('0' + frac / 100);
+        *--p = '.';
+        p = number::format_uint(p, ns / 1000, LogBase::DEC);
+        out.append(p, (size_t)(end - p));
+    }
+
+    inline void append_uint(std::string& out, const uint64_t v) {
+        char buf[number::INT_BUFFER_SIZE];
+        char* end = buf + sizeof(buf);
+        const char* p = number::format_uint(end, v, LogBase::DEC);
+        out.append(p, (size_t)(end - p));
+    }
+
+    // events of all threads in Chrome trace event format (chrome://tracing, https://ui.perfetto.dev)
+    inline void export_json(std::ostream& os) {
+        std::string out;
+        out.reserve(DEBUGLOG_ARRAY_CHUNK_SIZE * 2);
+        out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool b_first = true;
+        const auto separate = [&]() {
+            if (!b_first) out += ",";
+            out += "\n";
+            b_first = false;
+        };
+        // threads without events (e.g. after LOG_TRACE_CLEAR()) are omitted
+        Registry::get().for_each([&](Buffer& b) {
+            bool b_named = false;
+            const auto name_thread = [&]() {
+                separate();
+                out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+                append_uint(out, b.tid());
+                out += ",\"args\":{\"name\":\"thread ";
+                append_uint(out, b.tid());
+                if (b.dropped()) {
+                    out += " (";
+                    append_uint(out, b.dropped());
+                    out += " events dropped)";
+                }
+                out += "\"}}";
+                b_named = true;
+            };
+            b.for_each([&](const Event& e) {
+                if (!b_named) name_thread();
+                separate();
+                out += "{\"name\":\"";
+                append_json_escaped(out, e.site->name, strlen(e.site->name));
+                out += "\",\"cat\":\"DebugLog\",\"ph\":\"";
+                out += e.ph;
+                out += "\",\"ts\":";
+                append_us(out, e.ts);
+                if (e.ph == 'X') {
+                    out += ",\"dur\":";
+                    append_us(out, e.dur);
+                }
+                out += ",\"pid\":1,\"tid\":";
+                append_uint(out, b.tid());
+                out += ",\"args\":{\"file\":\"";
+                append_json_escaped(out, e.site->file, strlen(e.site->file));
+                out += "\",\"line\":";
+                append_uint(out, (uint64_t)e.site->line);
+                out += ",\"func\":\"";
+                append_json_escaped(out, e.site->func, strlen(e.site->func));
+                out += "\"}}";
+                if (out.size() >= DEBUGLOG_ARRAY_CHUNK_SIZE) {
+                    os.write(out.data(), (std::streamsize)out.size());
+                    out.clear();
+                }
+            });
+            if (!b_named && b.dropped()) name_thread();
+        });
+        out += "\n]}\n";
+        os.write(out.data(), (std::streamsize)out.size());
+        os.flush();
+    }
+
+    inline bool export_json(const std::string& path) {
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        export_json(ofs);
+        return ofs.good();
+    }
+
+}  // namespace trace
+}  // namespace debug
+}  // namespace arx
+
+#endif  // ARDUINO
+
+#endif  // DEBUGLOG_TRACE_H
@@ -21,6 +21,17 @@ static constexpr uint8_t BIN {2};
 #endif
 #endif
 
+#ifndef ARDUINO
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#endif
+
 namespace arx {
 namespace debug {
 
@@ -43,8 +54,227 @@ namespace debug {
 // serial loggers
 #ifdef ARDUINO
     using string_t = String;
+    using stream_t = Stream;
 #else
     using string_t = std::string;
+    using stream_t = std::ostream;
+#endif
+
+    // value which is written rarely and read on every log call
+    // std::atomic with relaxed ordering on C++ (no <atomic> on AVR, so plain value on Arduino)
+    template <typename T>
+    class RelaxedAtomic {
+#ifdef ARDUINO
+        volatile T v;
+#else
+        std::atomic<T> v;
+#endif
+
+    public:
+        // trivial, so zero-initialized in static storage without dynamic initialization
+        RelaxedAtomic() = default;
+        RelaxedAtomic(const T v)
+        : v(v) {}
+
+#ifdef ARDUINO
+        // read-modify-write is not atomic against interrupts on Arduino
+        T load() const { return v; }
+        void store(const T x) { v = x; }
+        T fetch_add(const T x) {
+            const T prev = v;
+            v = prev + x;
+            return prev;
+        }
+        T exchange(const T x) {
+            const T prev = v;
+            v = x;
+            return prev;
+        }
+        bool compare_exchange(T& expected, const T desired) {
+            if (v != expected) {
+                expected = v;
+                return false;
+            }
+            v = desired;
+            return true;
+        }
+#else
+        T load() const { return v.load(std::memory_order_relaxed); }
+        void store(const T x) { v.store(x, std::memory_order_relaxed); }
+        T fetch_add(const T x) { return v.fetch_add(x, std::memory_order_relaxed); }
+        T exchange(const T x) { return v.exchange(x, std::memory_order_relaxed); }
+        bool compare_exchange(T& expected, const T desired) { return v.compare_exchange_weak(expected, desired, std::memory_order_relaxed); }
+#endif
+    };
+
+    // compile-time string functions walk a string by chunks of this length, so the recursion depth is about
+    // length / CONSTEXPR_CHUNK + CONSTEXPR_CHUNK (C++11 constexpr functions cannot loop, and the depth is limited to 512)
+    static constexpr size_t CONSTEXPR_CHUNK {128};
+
+    // true if one of the first `n` characters of `s` is '\0' (the characters after it are not read)
+    constexpr bool has_nul(const char* s, const size_t n) {
+        return (n != 0) && (*s == '\0' || has_nul(s + 1, n - 1));
+    }
+
+#ifndef ARDUINO
+    // epoch based reclamation of the objects replaced in SharedSnapshot
+    // a thread publishes the global epoch while it is in SnapshotGuard, and a replaced object is freed
+    // once every thread in SnapshotGuard has entered it after the replacement
+    namespace snapshot {
+
+        struct Reader {
+            std::atomic<uint64_t> epoch {0};  // 0: not in SnapshotGuard
+            std::atomic<bool> b_used {true};
+            Reader* next {nullptr};
+        };
+
+        inline std::atomic<uint64_t>& global_epoch() {
+            static std::atomic<uint64_t> e {1};
+            return e;
+        }
+
+        // readers are never freed and are reused by later threads
+        inline std::atomic<Reader*>& readers() {
+            static std::atomic<Reader*> head {nullptr};
+            return head;
+        }
+
+        inline Reader* acquire_reader() {
+            for (Reader* r = readers().load(std::memory_order_acquire); r; r = r->next) {
+                bool b_used = false;
+                if (r->b_used.load(std::memory_order_relaxed)) continue;
+                if (r->b_used.compare_exchange_strong(b_used, true, std::memory_order_acquire)) return r;
+            }
+            Reader* r = new Reader();
+            Reader* head = readers().load(std::memory_order_relaxed);
+            do {
+                r->next = head;
+            } while (!readers().compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+            return r;
+        }
+
+        struct ThreadState {
+            Reader* reader;  // nullptr until the first SnapshotGuard (and after the thread exits)
+            size_t depth;
+        };
+
+        // trivial, so it is still usable from other thread_local destructors
+        inline ThreadState& thread_state() {
+            static thread_local ThreadState s {nullptr, 0};
+            return s;
+        }
+
+        // returns the reader to the list when the thread exits
+        struct ThreadExit {
+            ~ThreadExit() {
+                ThreadState& s = thread_state();
+                if (!s.reader) return;
+                s.reader->epoch.store(0, std::memory_order_release);
+                s.reader->b_used.store(false, std::memory_order_release);
+                s.reader = nullptr;
+            }
+        };
+
+        inline Reader* this_reader() {
+            ThreadState& s = thread_state();
+            if (!s.reader) {
+                s.reader = acquire_reader();
+                static thread_local ThreadExit exit;
+                (void)exit;
+            }
+            return s.reader;
+        }
+
+        // the oldest epoch which a thread in SnapshotGuard may have seen (UINT64_MAX if none)
+        // `except` (the caller) is skipped
+        inline uint64_t min_epoch(const Reader* except = nullptr) {
+            uint64_t m = UINT64_MAX;
+            for (Reader* r = readers().load(std::memory_order_acquire); r; r = r->next) {
+                if (r == except) continue;
+                const uint64_t e = r->epoch.load();
+                if (e && e < m) m = e;
+            }
+            return m;
+        }
+
+    }  // namespace snapshot
+
+    // pointers loaded from SharedSnapshot are valid until the outermost guard of the thread exits
+    // (nested guards only count the depth)
+    class SnapshotGuard {
+        snapshot::Reader* r;
+
+    public:
+        SnapshotGuard()
+        : r(snapshot::this_reader()) {
+            if (snapshot::thread_state().depth++ == 0) r->epoch.store(snapshot::global_epoch().load());
+        }
+
+        ~SnapshotGuard() {
+            if (--snapshot::thread_state().depth == 0) r->epoch.store(0, std::memory_order_release);
+        }
+
+        SnapshotGuard(const SnapshotGuard&) = delete;
+        SnapshotGuard& operator=(const SnapshotGuard&) = delete;
+    };
+
+    // object which is replaced rarely and read lock-free on every log call
+    // load() is called in SnapshotGuard (or by the writer which holds its own lock),
+    // and replaced objects are freed when no reader can still use them
+    template <typename T>
+    class SharedSnapshot {
+        std::atomic<T*> ptr {nullptr};
+        std::vector<std::pair<uint64_t, std::unique_ptr<T>>> retired;  // epoch of the replacement and the object
+        std::mutex mtx;
+
+    public:
+        ~SharedSnapshot() {
+            delete ptr.load();
+        }
+
+        T* load() const { return ptr.load(); }
+
+        T* store(T* p) {
+            std::lock_guard<std::mutex> lock(mtx);
+            retire(ptr.exchange(p));
+            return p;
+        }
+
+        void reset() { store(nullptr); }
+
+        // frees the replaced objects which are no longer used (also done by every store())
+        void reclaim() {
+            std::lock_guard<std::mutex> lock(mtx);
+            reclaim_unlocked(snapshot::min_epoch());
+        }
+
+        // waits until the threads which may use the replaced objects leave SnapshotGuard and frees them
+        // the calling thread is not waited for (it may be logging), and store() is not blocked while waiting
+        void synchronize() {
+            uint64_t last = 0;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (retired.empty()) return;
+                last = retired.back().first;
+            }
+            const snapshot::Reader* self = snapshot::thread_state().reader;
+            while (snapshot::min_epoch(self) < last) std::this_thread::yield();
+            std::lock_guard<std::mutex> lock(mtx);
+            reclaim_unlocked(snapshot::min_epoch());
+        }
+
+    private:
+        void retire(T* old) {
+            if (old) retired.emplace_back(snapshot::global_epoch().fetch_add(1) + 1, std::unique_ptr<T>(old));
+            reclaim_unlocked(snapshot::min_epoch());
+        }
+
+        void reclaim_unlocked(const uint64_t min_epoch) {
+            size_t n = 0;
+            while (n < retired.size() && retired[n].first <= min_epoch) ++n;
+            retired.erase(retired.begin(), retired.begin() + n);
+        }
+    };
 #endif
 
     enum class LogLevel {
@@ -60,12 +290,9 @@ namespace debug {
         DEC = 10,
         HEX = 16,
         OCT = 8,
-#ifdef ARDUINO
         BIN = 2,
-#endif
     };
 
-#ifdef ARDUINO
     enum class LogPrecision {
         ZERO,
         ONE,
@@ -77,7 +304,38 @@ namespace debug {
         SEVEN,
         EIGHT,
     };
+
+    // what to do with a new record when the queue (or Serial TX buffer on Arduino) is full
+    enum class OverflowPolicy {
+        BLOCK,        // wait until there is space
+        DROP_NEWEST,  // discard the new record
+        DROP_OLDEST,  // discard the oldest queued records to make space (same as DROP_NEWEST on Arduino)
+        DROP_BELOW,   // discard the new record if it is less severe than the given level, otherwise wait
+    };
+
+    // timestamp after the level tag of LOG_XXXX
+    enum class LogTimestamp {
+        NONE,    // no timestamp (default)
+        UPTIME,  // seconds since the start of the program ("12.345678")
+        LOCAL,   // local date and time ("2026-10-18 12:34:56.123456") (same as UPTIME on Arduino)
+        UTC,     // UTC date and time (same as UPTIME on Arduino)
+    };
+
+    // formatting state which is changed by LogBase and LogPrecision arguments
+    // kept per thread on C++ so that a manipulator does not affect logs from other threads
+    struct FormatState {
+        LogBase base {LogBase::DEC};
+#ifdef ARDUINO
+        LogPrecision precision {LogPrecision::TWO};
+#else
+        int precision {-1};  // 6 significant digits (same as std::ostream) until LogPrecision is given
 #endif
+    };
+
+    struct Delimiter {
+        string_t str;
+        uint32_t id;  // changed every time the delimiter is changed
+    };
 
     template <typename T>
     struct Array {
@@ -97,6 +355,29 @@ namespace debug {
         return Array<T>(ptr, sz);
     }
 
+    // byte buffer printed as compact hex ("01 a0 ff")
+    struct HexDump {
+        const uint8_t* ptr;
+        size_t sz;
+    };
+
+    inline HexDump to_hexdump(const void* ptr, const size_t sz) {
+        return HexDump {static_cast<const uint8_t*>(ptr), sz};
+    }
+
+#ifndef ARDUINO
+    // used when HexDump is stored as a string (e.g. binary log)
+    inline std::ostream& operator<<(std::ostream& os, const HexDump& h) {
+        static constexpr char digits[] = "0123456789abcdef";
+        for (size_t i = 0; i < h.sz; ++i) {
+            if (i) os.put(' ');
+            os.put(digits[h.ptr[i] >> 4]);
+            os.put(digits[h.ptr[i] & 0xF]);
+        }
+        return os;
+    }
+#endif
+
 }  // namespace debug
 }  // namespace arx
 
@@ -132,4 +413,26 @@ namespace debug {
 #define DEBUGLOG_DEFAULT_FILE_LEVEL LogLevel::LVL_ERROR
 #endif
 
+// arrays / containers and hexdump longer than these are cut with "... (N more)" (0: unlimited)
+#ifndef DEBUGLOG_MAX_ELEMENTS
+#define DEBUGLOG_MAX_ELEMENTS 0
+#endif
+#ifndef DEBUGLOG_MAX_HEXDUMP_BYTES
+#define DEBUGLOG_MAX_HEXDUMP_BYTES 0
+#endif
+
+// free bytes of the Serial TX buffer required to start a record unless OverflowPolicy::BLOCK (Arduino)
+#ifndef DEBUGLOG_OVERFLOW_TX_SPACE
+#define DEBUGLOG_OVERFLOW_TX_SPACE 16
+#endif
+
+// bytes of hexdump formatted on the stack at once
+#ifndef DEBUGLOG_HEXDUMP_CHUNK_SIZE
+#ifdef ARDUINO
+#define DEBUGLOG_HEXDUMP_CHUNK_SIZE 16
+#else
+#define DEBUGLOG_HEXDUMP_CHUNK_SIZE 256
+#endif
+#endif
+
 #endif  // DEBUGLOG_TYPES_H
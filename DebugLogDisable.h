@@ -5,6 +5,20 @@
 #undef LOG_TRACE
 #undef ASSERT
 #undef ASSERTM
+#undef LOG_LIMITED_ERROR
+#undef LOG_LIMITED_WARN
+#undef LOG_LIMITED_INFO
+#undef LOG_LIMITED_DEBUG
+#undef LOG_LIMITED_TRACE
+#undef LOG_SCOPE
+#undef LOG_TRACE_BEGIN
+#undef LOG_TRACE_END
+#undef LOG_CONTEXT
+#undef LOG_ERRORF
+#undef LOG_WARNF
+#undef LOG_INFOF
+#undef LOG_DEBUGF
+#undef LOG_TRACEF
 
 #define LOG_ERROR(...) ((void)0)
 #define LOG_WARN(...) ((void)0)
@@ -13,3 +27,17 @@
 #define LOG_TRACE(...) ((void)0)
 #define ASSERT(...) ((void)0)
 #define ASSERTM(...) ((void)0)
+#define LOG_LIMITED_ERROR(...) ((void)0)
+#define LOG_LIMITED_WARN(...) ((void)0)
+#define LOG_LIMITED_INFO(...) ((void)0)
+#define LOG_LIMITED_DEBUG(...) ((void)0)
+#define LOG_LIMITED_TRACE(...) ((void)0)
+#define LOG_SCOPE(...)
+#define LOG_TRACE_BEGIN(...) ((void)0)
+#define LOG_TRACE_END(...) ((void)0)
+#define LOG_CONTEXT(...)
+#define LOG_ERRORF(...) ((void)0)
+#define LOG_WARNF(...) ((void)0)
+#define LOG_INFOF(...) ((void)0)
+#define LOG_DEBUGF(...) ((void)0)
+#define LOG_TRACEF(...) ((void)0)
@@ -5,61 +5,234 @@
 #undef LOG_TRACE
 #undef ASSERT
 #undef ASSERTM
+#undef LOG_MACRO_CALL
+#undef LOG_BINARY_SITE
+#undef LOG_SHORT_FILENAME
+#undef LOG_CALLSITE
+#undef LOG_MACRO_BODY
+#undef LOG_FILTER_SITE
+#undef LOG_IS_ENABLED
+#undef LOG_SITE_LEVEL
+#undef LOG_RATE_LIMITER
+#undef LOG_LIMITED_CALL
+#undef LOG_LIMITED_ERROR
+#undef LOG_LIMITED_WARN
+#undef LOG_LIMITED_INFO
+#undef LOG_LIMITED_DEBUG
+#undef LOG_LIMITED_TRACE
+#undef LOG_TRACE_SITE
+#undef LOG_SCOPE_CALL
+#undef LOG_TRACE_BEGIN_CALL
+#undef LOG_TRACE_END_CALL
+#undef LOG_SCOPE
+#undef LOG_TRACE_BEGIN
+#undef LOG_TRACE_END
+#undef LOG_CONTEXT
+#undef LOG_FORMAT_HEAD
+#undef LOG_FORMAT_SITE
+#undef LOG_FORMAT_CALL
+#undef LOG_ERRORF
+#undef LOG_WARNF
+#undef LOG_INFOF
+#undef LOG_DEBUGF
+#undef LOG_TRACEF
 
-#define LOG_SHORT_FILENAME (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
+#define LOG_SHORT_FILENAME ([]() -> const char* { static constexpr const char* f = arx::debug::short_filename(__FILE__); return f; }())
 
 // C pre-proc Token Concatenation: https://wiki.sei.cmu.edu/confluence/display/c/PRE05-C.+Understand+macro+replacement+when+concatenating+tokens+or+performing+stringification
 #define LOG_MACRO_APPEND_STR(s) LOG_HELPER_MACRO_APPEND_STR(s)
 #define LOG_HELPER_MACRO_APPEND_STR(s) #s
 
+// file, line and function of the call site are computed only once and printed with one write
+#define LOG_CALLSITE() ([](const char* func) -> const arx::debug::CallSite& { static const arx::debug::CallSite site = DebugLog::Manager::get().callsite(LOG_SHORT_FILENAME, LOG_MACRO_APPEND_STR(L.__LINE__), func); return site; }(__func__))
+
 #ifndef LOG_PREAMBLE
-  #define LOG_PREAMBLE LOG_SHORT_FILENAME, LOG_MACRO_APPEND_STR(L.__LINE__), __func__, ":"
+  #define LOG_PREAMBLE LOG_CALLSITE()
 #endif
 
+#ifdef DEBUGLOG_HAS_SITE_FILTER
+  // state of each call site is checked before the levels and registered to the site table at the first check
+  // the slot is keyed by the file, line and level, so the check and the record refer to the same state
+  #define LOG_FILTER_SITE(lvl) arx::debug::SiteSlot<arx::debug::site_hash(__FILE__), __LINE__, lvl>
+  #define LOG_IS_ENABLED(lvl) (!LOG_FILTER_SITE(lvl)::is_off() && DebugLog::Manager::is_enabled(LOG_FILTER_SITE(lvl)::site, lvl, __FILE__, __LINE__, __func__))
+  #define LOG_SITE_LEVEL(lvl) LOG_FILTER_SITE(lvl)::level()
+#else
+  #define LOG_IS_ENABLED(lvl) DebugLog::Manager::get().is_enabled(lvl)
+  #define LOG_SITE_LEVEL(lvl) lvl
+#endif
+
+#if defined(DEBUGLOG_ENABLE_BINARY_LOG) && !defined(ARDUINO)
+  // static descriptor of each call site is registered once and only raw arguments are written
+  #define LOG_BINARY_SITE(lvl) ([](const char* func) -> arx::debug::BinarySite& { static arx::debug::BinarySite site(lvl, LOG_SHORT_FILENAME, __LINE__, func); return site; }(__func__))
+  #define LOG_MACRO_BODY(lvl, ...) DebugLog::Manager::get().log_binary(LOG_BINARY_SITE(lvl), LOG_SITE_LEVEL(lvl), __VA_ARGS__)
+#else
+  #define LOG_MACRO_BODY(lvl, ...) DebugLog::Manager::get().log(LOG_SITE_LEVEL(lvl), LOG_PREAMBLE, __VA_ARGS__)
+#endif
+// the level is checked first, so arguments are not evaluated if the level is filtered out
+#define LOG_MACRO_CALL(lvl, ...) (LOG_IS_ENABLED(lvl) ? LOG_MACRO_BODY(lvl, __VA_ARGS__) : (void)0)
+
+// rate limited log: the level and then the per call site limiter are checked before the arguments are evaluated
+// the number of suppressed messages is appended when the call site logs again
+#define LOG_RATE_LIMITER() ([]() -> arx::debug::RateLimiter& { static arx::debug::RateLimiter r; return r; }())
+#define LOG_LIMITED_CALL(lvl, check, ...) \
+    for (uint32_t debuglog_n = LOG_IS_ENABLED(lvl) ? LOG_RATE_LIMITER().check : 0; debuglog_n != 0; debuglog_n = 0) \
+        (debuglog_n == 1) ? LOG_MACRO_BODY(lvl, __VA_ARGS__) : LOG_MACRO_BODY(lvl, __VA_ARGS__, arx::debug::Suppressed {debuglog_n - 1})
+
+// LOG_XXXXF(fmt, args...): the format string literal is checked against the argument types at compile time
+// and split into literal pieces once per call site (always written as text even if the binary log is enabled)
+#define LOG_FORMAT_HEAD(fmt, ...) fmt
+#define LOG_FORMAT_SITE(...) ([]() -> const arx::debug::fmt::Site<arx::debug::fmt::max_pieces(LOG_FORMAT_HEAD(__VA_ARGS__, ~))>& { \
+    using checker_t = decltype(arx::debug::fmt::checker(__VA_ARGS__)); \
+    static_assert(checker_t::check(LOG_FORMAT_HEAD(__VA_ARGS__, ~)) != arx::debug::fmt::Error::SYNTAX, "LOG_XXXXF: invalid placeholder (use {}, {:d}, {:x}, {:o}, {:b}, {:.N}, {{ or }})"); \
+    static_assert(checker_t::check(LOG_FORMAT_HEAD(__VA_ARGS__, ~)) != arx::debug::fmt::Error::TOO_FEW_ARGS, "LOG_XXXXF: more placeholders than arguments"); \
+    static_assert(checker_t::check(LOG_FORMAT_HEAD(__VA_ARGS__, ~)) != arx::debug::fmt::Error::TOO_MANY_ARGS, "LOG_XXXXF: more arguments than placeholders"); \
+    static_assert(checker_t::check(LOG_FORMAT_HEAD(__VA_ARGS__, ~)) != arx::debug::fmt::Error::SPEC_MISMATCH, "LOG_XXXXF: {:d} {:x} {:o} {:b} need integers and {:.N} needs floating point numbers"); \
+    static const arx::debug::fmt::Site<arx::debug::fmt::max_pieces(LOG_FORMAT_HEAD(__VA_ARGS__, ~))> site(LOG_FORMAT_HEAD(__VA_ARGS__, ~)); \
+    return site; }())
+#define LOG_FORMAT_CALL(lvl, ...) (LOG_IS_ENABLED(lvl) ? DebugLog::Manager::get().log(LOG_SITE_LEVEL(lvl), LOG_PREAMBLE, arx::debug::fmt::message(LOG_FORMAT_SITE(__VA_ARGS__), __VA_ARGS__)) : (void)0)
+
+// scoped timing and trace events are recorded to the per-thread buffer at the TRACE level of compile-time gating
+// `name` must be a string literal and is exported by LOG_TRACE_EXPORT()
+#define LOG_MACRO_CONCAT(a, b) LOG_HELPER_MACRO_CONCAT(a, b)
+#define LOG_HELPER_MACRO_CONCAT(a, b) a##b
+#ifdef ARDUINO
+  #define LOG_SCOPE_CALL(name)
+  #define LOG_TRACE_BEGIN_CALL(name)
+  #define LOG_TRACE_END_CALL(name)
+#else
+  #define LOG_TRACE_SITE(name) ([](const char* func) -> const arx::debug::trace::Site& { static const arx::debug::trace::Site site {name, LOG_SHORT_FILENAME, __LINE__, func}; return site; }(__func__))
+  #define LOG_SCOPE_CALL(name) const arx::debug::trace::Scope LOG_MACRO_CONCAT(debuglog_scope_, __LINE__)(LOG_TRACE_SITE(name))
+  #define LOG_TRACE_BEGIN_CALL(name) arx::debug::trace::begin(LOG_TRACE_SITE(name))
+  #define LOG_TRACE_END_CALL(name) arx::debug::trace::end(LOG_TRACE_SITE(name))
+#endif
+
+// "key=value " is rendered once and written after the level tag and the timestamp of every record of this thread until the scope exits
+#define LOG_CONTEXT(key, value) const arx::debug::ContextScope LOG_MACRO_CONCAT(debuglog_context_, __LINE__)(key, value)
+
 #if defined(DEBUGLOG_DEFAULT_LOG_LEVEL_ERROR)
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
   #define  LOG_WARN(...)
+  #define LOG_LIMITED_WARN(check, ...)
+  #define LOG_WARNF(...)
   #define  LOG_INFO(...)
+  #define LOG_LIMITED_INFO(check, ...)
+  #define LOG_INFOF(...)
   #define LOG_DEBUG(...)
+  #define LOG_LIMITED_DEBUG(check, ...)
+  #define LOG_DEBUGF(...)
   #define LOG_TRACE(...)
+  #define LOG_LIMITED_TRACE(check, ...)
+  #define LOG_TRACEF(...)
+  #define LOG_SCOPE(name)
+  #define LOG_TRACE_BEGIN(name)
+  #define LOG_TRACE_END(name)
 #elif defined(DEBUGLOG_DEFAULT_LOG_LEVEL_WARN)
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_WARN(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_WARN, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define  LOG_WARN(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define LOG_LIMITED_WARN(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_WARN, check, __VA_ARGS__)
+  #define LOG_WARNF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
   #define  LOG_INFO(...)
+  #define LOG_LIMITED_INFO(check, ...)
+  #define LOG_INFOF(...)
   #define LOG_DEBUG(...)
+  #define LOG_LIMITED_DEBUG(check, ...)
+  #define LOG_DEBUGF(...)
   #define LOG_TRACE(...)
+  #define LOG_LIMITED_TRACE(check, ...)
+  #define LOG_TRACEF(...)
+  #define LOG_SCOPE(name)
+  #define LOG_TRACE_BEGIN(name)
+  #define LOG_TRACE_END(name)
 #elif defined(DEBUGLOG_DEFAULT_LOG_LEVEL_INFO)
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_WARN(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_WARN, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_INFO(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_INFO, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define  LOG_WARN(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define LOG_LIMITED_WARN(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_WARN, check, __VA_ARGS__)
+  #define LOG_WARNF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define  LOG_INFO(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_LIMITED_INFO(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_INFO, check, __VA_ARGS__)
+  #define LOG_INFOF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
   #define LOG_DEBUG(...)
+  #define LOG_LIMITED_DEBUG(check, ...)
+  #define LOG_DEBUGF(...)
   #define LOG_TRACE(...)
+  #define LOG_LIMITED_TRACE(check, ...)
+  #define LOG_TRACEF(...)
+  #define LOG_SCOPE(name)
+  #define LOG_TRACE_BEGIN(name)
+  #define LOG_TRACE_END(name)
 #elif defined(DEBUGLOG_DEFAULT_LOG_LEVEL_DEBUG)
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_WARN(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_WARN, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_INFO(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_INFO, LOG_PREAMBLE, __VA_ARGS__)
-  #define LOG_DEBUG(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_DEBUG, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define  LOG_WARN(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define LOG_LIMITED_WARN(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_WARN, check, __VA_ARGS__)
+  #define LOG_WARNF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define  LOG_INFO(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_LIMITED_INFO(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_INFO, check, __VA_ARGS__)
+  #define LOG_INFOF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_DEBUG(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
+  #define LOG_LIMITED_DEBUG(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_DEBUG, check, __VA_ARGS__)
+  #define LOG_DEBUGF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
   #define LOG_TRACE(...)
+  #define LOG_LIMITED_TRACE(check, ...)
+  #define LOG_TRACEF(...)
+  #define LOG_SCOPE(name)
+  #define LOG_TRACE_BEGIN(name)
+  #define LOG_TRACE_END(name)
 #elif defined(DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE)
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_WARN(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_WARN, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_INFO(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_INFO, LOG_PREAMBLE, __VA_ARGS__)
-  #define LOG_DEBUG(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_DEBUG, LOG_PREAMBLE, __VA_ARGS__)
-  #define LOG_TRACE(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_TRACE, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define  LOG_WARN(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define LOG_LIMITED_WARN(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_WARN, check, __VA_ARGS__)
+  #define LOG_WARNF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define  LOG_INFO(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_LIMITED_INFO(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_INFO, check, __VA_ARGS__)
+  #define LOG_INFOF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_DEBUG(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
+  #define LOG_LIMITED_DEBUG(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_DEBUG, check, __VA_ARGS__)
+  #define LOG_DEBUGF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
+  #define LOG_TRACE(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_TRACE, __VA_ARGS__)
+  #define LOG_LIMITED_TRACE(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_TRACE, check, __VA_ARGS__)
+  #define LOG_TRACEF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_TRACE, __VA_ARGS__)
+  #define LOG_SCOPE(name) LOG_SCOPE_CALL(name)
+  #define LOG_TRACE_BEGIN(name) LOG_TRACE_BEGIN_CALL(name)
+  #define LOG_TRACE_END(name) LOG_TRACE_END_CALL(name)
 #else
   #warning "Defaulting to a log level of: DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE"
-  #define LOG_ERROR(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_ERROR, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_WARN(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_WARN, LOG_PREAMBLE, __VA_ARGS__)
-  #define  LOG_INFO(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_INFO, LOG_PREAMBLE, __VA_ARGS__)
-  #define LOG_DEBUG(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_DEBUG, LOG_PREAMBLE, __VA_ARGS__)
-  #define LOG_TRACE(...) DebugLog::Manager::get().log(arx::debug::LogLevel::LVL_TRACE, LOG_PREAMBLE, __VA_ARGS__)
+  #define LOG_ERROR(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define LOG_LIMITED_ERROR(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_ERROR, check, __VA_ARGS__)
+  #define LOG_ERRORF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_ERROR, __VA_ARGS__)
+  #define  LOG_WARN(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define LOG_LIMITED_WARN(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_WARN, check, __VA_ARGS__)
+  #define LOG_WARNF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_WARN, __VA_ARGS__)
+  #define  LOG_INFO(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_LIMITED_INFO(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_INFO, check, __VA_ARGS__)
+  #define LOG_INFOF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_INFO, __VA_ARGS__)
+  #define LOG_DEBUG(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
+  #define LOG_LIMITED_DEBUG(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_DEBUG, check, __VA_ARGS__)
+  #define LOG_DEBUGF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_DEBUG, __VA_ARGS__)
+  #define LOG_TRACE(...) LOG_MACRO_CALL(arx::debug::LogLevel::LVL_TRACE, __VA_ARGS__)
+  #define LOG_LIMITED_TRACE(check, ...) LOG_LIMITED_CALL(arx::debug::LogLevel::LVL_TRACE, check, __VA_ARGS__)
+  #define LOG_TRACEF(...) LOG_FORMAT_CALL(arx::debug::LogLevel::LVL_TRACE, __VA_ARGS__)
+  #define LOG_SCOPE(name) LOG_SCOPE_CALL(name)
+  #define LOG_TRACE_BEGIN(name) LOG_TRACE_BEGIN_CALL(name)
+  #define LOG_TRACE_END(name) LOG_TRACE_END_CALL(name)
 #endif
 
-#ifdef ARDUINO
-#define ASSERT(b) DebugLog::Manager::get().assertion((b), LOG_SHORT_FILENAME, __LINE__, __func__, #b)
-#define ASSERTM(b, msg) DebugLog::Manager::get().assertion((b), LOG_SHORT_FILENAME, __LINE__, __func__, #b, msg)
-#else  // ARDUINO
-#include <cassert>
-#define ASSERT(b) assert(b)
-#define ASSERTM(b, msg) assert((msg, b))
-#endif  // ARDUINO
+// the flight recorder is dumped before "[ASSERT] ..." is printed
+// C++ : abort() after that, and compiled out if NDEBUG is defined (same as assert())
+// Arduino : suspends the program
+#if defined(ARDUINO) || !defined(NDEBUG)
+#define ASSERT(b) ((b) ? (void)0 : DebugLog::Manager::get().assertion(false, LOG_SHORT_FILENAME, __LINE__, __func__, #b))
+#define ASSERTM(b, msg) ((b) ? (void)0 : DebugLog::Manager::get().assertion(false, LOG_SHORT_FILENAME, __LINE__, __func__, #b, msg))
+#else
+#define ASSERT(b) ((void)0)
+#define ASSERTM(b, msg) ((void)0)
+#endif
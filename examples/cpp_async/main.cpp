@@ -0,0 +1,43 @@
+// You can also set default log level by defining macro (default: INFO)
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_INFO
+
+// You can change the size of the ring buffer for async mode (default: 1 MB)
+// #define DEBUGLOG_ASYNC_BUFFER_SIZE (1 << 16)
+
+#include "../../DebugLog.h"
+
+#include <thread>
+#include <vector>
+
+int main() {
+    // Logs are written by the calling thread by default (synchronous mode)
+    LOG_INFO("this is written synchronously");
+
+    // After LOG_ASYNC_START(), LOG_XXXX / PRINT / PRINTLN only format the record
+    // and push it to the lock-free ring buffer. The background thread writes them to std::cout
+    LOG_ASYNC_START();
+
+    // If std::cout is slower than logging (e.g. blocked pipe), LOG_XXXX waits for space by default.
+    // Records can be dropped instead, so that time-critical threads never stall on logging.
+    // Dropped records are counted per level and reported as one WARN record when the queue has space.
+    LOG_SET_OVERFLOW_POLICY(DebugLogOverflow::DROP_BELOW, DebugLogLevel::LVL_WARN);  // ERROR and WARN still wait
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 5; ++i) {
+                LOG_INFO("thread", t, "count", i);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    // Block until all queued logs are written
+    LOG_ASYNC_FLUSH();
+    PRINTLN("all logs from threads are written, dropped:", LOG_GET_DROPPED());
+
+    // Write all queued logs and go back to synchronous mode
+    // (this is also done automatically at exit)
+    LOG_ASYNC_STOP();
+    LOG_INFO("this is written synchronously again");
+}
@@ -0,0 +1,356 @@
+// Microbenchmarks of the logging path on host
+// stdout is redirected to /dev/null and the results are printed to std::cerr
+//
+// build : g++ -std=c++11 -O2 -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> main.cpp -o benchmark -pthread
+
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+template <typename F>
+void bench(const char* name, const size_t n, F&& f) {
+    for (size_t i = 0; i < n / 10; ++i) f(i);  // warm up
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) f(i);
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - begin).count() / n;
+    std::cerr << std::left << std::setw(48) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1) << ns << " ns/call" << std::endl;
+}
+
+// preamble of DebugLog <= v0.8.4 (strrchr for every call and four tokens)
+#define OLD_SHORT_FILENAME (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
+#define OLD_PREAMBLE OLD_SHORT_FILENAME, LOG_MACRO_APPEND_STR(L.__LINE__), __func__, ":"
+
+void bench_preamble(const size_t n) {
+    std::cerr << "--- call site preamble ---" << std::endl;
+    bench("preamble: four tokens + strrchr (old)", n, [](size_t i) {
+        DebugLog::Manager::get().log(DebugLogLevel::LVL_INFO, OLD_PREAMBLE, "value", i);
+    });
+    bench("preamble: LOG_CALLSITE (one write)", n, [](size_t i) {
+        LOG_INFO("value", i);
+    });
+}
+
+void bench_line(const size_t n) {
+    std::cerr << "--- whole line in one write ---" << std::endl;
+    bench("PRINTLN with 8 args", n, [](size_t i) {
+        PRINTLN("a", 1, "b", 2.5, "c", i, "d", "e");
+    });
+    bench("LOG_INFO with 4 args", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+}
+
+std::string expensive(const size_t i) {
+    return std::to_string(i) + std::string(64, '-');
+}
+
+void bench_format(const size_t n) {
+    std::cerr << "--- format string ---" << std::endl;
+    bench("LOG_INFO(\"x=\", i, \"y=\", 3.14, \"hex\", HEX, i)", n, [](size_t i) {
+        LOG_INFO("x=", i, "y=", 3.14, "hex", DebugLogBase::HEX, i);
+    });
+    bench("LOG_INFOF(\"x={} y={} hex {:x}\", i, 3.14, i)", n, [](size_t i) {
+        LOG_INFOF("x={} y={} hex {:x}", i, 3.14, i);
+    });
+    // long format strings are also checked at compile time
+    bench("LOG_INFOF with a 610 character format string", n, [](size_t i) {
+        LOG_INFOF(
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- "
+            "x={} ------------------------------------------------------- ",
+            i, i, i, i, i, i, i, i, i, i);
+    });
+}
+
+void bench_disabled_site(const size_t i) {
+    LOG_TRACE("value", expensive(i), std::vector<size_t>(16, i));
+}
+
+void bench_filtered(const size_t n) {
+    std::cerr << "--- filtered LOG_TRACE (log level: INFO, flight recorder: TRACE (default)) ---" << std::endl;
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+    volatile bool b_enabled = false;
+    volatile size_t sink = 0;
+    bench("branch only (reference)", n, [&](size_t i) {
+        if (b_enabled) sink = i;
+    });
+    // the arguments are evaluated for the recorder and kept without formatting
+    bench("LOG_TRACE with expensive argument", n / 10, [](size_t i) {
+        LOG_TRACE("value", expensive(i), std::vector<size_t>(16, i));
+    });
+    bench("LOG_TRACE kept only in the flight recorder", n / 10, [](size_t i) {
+        LOG_TRACE("x", i, "y", 3.14);
+    });
+    LOG_RECORDER_FOLLOW_OUTPUTS();
+    bench("expensive argument, recorder follows outputs", n, [](size_t i) {
+        LOG_TRACE("value", expensive(i), std::vector<size_t>(16, i));
+    });
+    bench("log() with expensive argument (eager)", n, [](size_t i) {
+        DebugLog::Manager::get().log(DebugLogLevel::LVL_TRACE, "value", expensive(i), std::vector<size_t>(16, i));
+    });
+    LOG_DISABLE_SITES("func:bench_disabled_site");
+    bench("LOG_TRACE at a site disabled by LOG_DISABLE_SITES", n, [](size_t i) {
+        bench_disabled_site(i);
+    });
+    LOG_RESET_SITES();
+    LOG_SET_RECORDER_LEVEL(DebugLogLevel::LVL_TRACE);
+    LOG_SET_LEVEL(DebugLogLevel::LVL_TRACE);
+}
+
+void bench_numbers(const size_t n) {
+    std::cerr << "--- number formatting ---" << std::endl;
+    std::vector<float> floats(4096);
+    std::vector<int> ints(4096);
+    for (size_t i = 0; i < floats.size(); ++i) {
+        floats[i] = (float)i * 0.37f - 500.f;
+        ints[i] = (int)(i * 2654435761u);
+    }
+    bench("PRINTLN LOG_AS_ARR(float, 4096)", n, [&](size_t) {
+        PRINTLN(LOG_AS_ARR(floats.data(), floats.size()));
+    });
+    bench("PRINTLN LOG_AS_ARR(int, 4096)", n, [&](size_t) {
+        PRINTLN(LOG_AS_ARR(ints.data(), ints.size()));
+    });
+    bench("PRINTLN LOG_AS_ARR(int, 4096) in HEX", n, [&](size_t) {
+        PRINTLN(DebugLogBase::HEX, LOG_AS_ARR(ints.data(), ints.size()));
+    });
+    bench("PRINTLN LOG_AS_ARR(float, 4096) in FOUR", n, [&](size_t) {
+        PRINTLN(DebugLogPrecision::FOUR, LOG_AS_ARR(floats.data(), floats.size()));
+    });
+    bench("PRINTLN std::vector<int>(4096)", n, [&](size_t) {
+        PRINTLN(ints);
+    });
+    bench("PRINTLN LOG_AS_HEXDUMP(4096 bytes)", n, [&](size_t) {
+        PRINTLN(LOG_AS_HEXDUMP(ints.data(), ints.size()));
+    });
+}
+
+// sink which only counts bytes
+class NullSink : public DebugLog::Sink {
+public:
+    size_t n_bytes {0};
+    void write(const char*, const size_t size) override { n_bytes += size; }
+};
+
+void bench_sinks(const size_t n) {
+    std::cerr << "--- sinks (std::cout disabled) ---" << std::endl;
+    LOG_SET_LEVEL(DebugLogLevel::LVL_NONE);
+    auto json = std::make_shared<DebugLog::JsonFormatter>();
+    std::vector<uint32_t> ids;
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE));
+    bench("LOG_INFO to 1 sink", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE));
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE));
+    bench("LOG_INFO to 3 sinks (one format)", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE, json));
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE, json));
+    bench("LOG_INFO to 5 sinks (text + shared JSON)", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    ids.push_back(LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE, nullptr, 1 << 20));
+    bench("LOG_INFO to 6 sinks (+ one queued)", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    for (const uint32_t id : ids) LOG_REMOVE_SINK(id);
+
+    // drained by a thread in place of tools/shm_log_collector
+    auto ring = std::make_shared<DebugLog::ShmRingSink>("debuglog_benchmark");
+    if (ring->is_open()) {
+        const uint32_t id = LOG_ADD_SINK(ring, DebugLogLevel::LVL_TRACE);
+        std::atomic<bool> b_done {false};
+        std::thread collector([&] {
+            DebugLog::shm_ring::Ring r;
+            std::string buf;
+            r.open(ring->name());
+            while (!b_done) r.drain([](uint64_t, uint32_t, const char*, size_t) {}, 1000000000, buf);
+        });
+        bench("LOG_INFO to ShmRingSink", n, [](size_t i) {
+            LOG_INFO("x", i, "y", 3.14);
+        });
+        b_done = true;
+        collector.join();
+        LOG_REMOVE_SINK(id);
+        std::cerr << "ShmRingSink dropped: " << ring->dropped() << std::endl;
+        shm_unlink(ring->name().c_str());
+    }
+
+    const uint32_t indexed = LOG_ADD_SINK(std::make_shared<DebugLog::IndexedFileSink>("/dev/null"), DebugLogLevel::LVL_TRACE);
+    bench("LOG_INFO to IndexedFileSink", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    LOG_REMOVE_SINK(indexed);
+    LOG_SET_LEVEL(DebugLogLevel::LVL_TRACE);
+}
+
+void bench_trace(const size_t n) {
+    std::cerr << "--- trace events (per-thread buffer) ---" << std::endl;
+    volatile size_t sink = 0;
+    bench("LOG_SCOPE", n, [&](size_t i) {
+        LOG_SCOPE("scope");
+        sink = i;
+    });
+    bench("LOG_TRACE_BEGIN + LOG_TRACE_END", n, [&](size_t i) {
+        LOG_TRACE_BEGIN("span");
+        sink = i;
+        LOG_TRACE_END("span");
+    });
+    std::ostringstream os;
+    const auto begin = std::chrono::steady_clock::now();
+    LOG_TRACE_EXPORT(os);
+    const auto end = std::chrono::steady_clock::now();
+    std::cerr << "LOG_TRACE_EXPORT: " << os.str().size() / 1024 << " KB in " << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << std::endl;
+}
+
+void bench_timestamp(const size_t n) {
+    std::cerr << "--- LOG_INFO with header timestamp ---" << std::endl;
+    bench("LOG_INFO without timestamp", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    LOG_SET_TIMESTAMP(DebugLogTimestamp::UPTIME);
+    bench("LOG_INFO with UPTIME", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    LOG_SET_TIMESTAMP(DebugLogTimestamp::LOCAL);
+    bench("LOG_INFO with LOCAL", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    LOG_SET_TIMESTAMP(DebugLogTimestamp::UTC, 3);
+    bench("LOG_INFO with UTC (3 digits)", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    LOG_SET_TIMESTAMP(DebugLogTimestamp::NONE);
+    volatile size_t sink = 0;
+    bench("system_clock + localtime + strftime (reference)", n, [&](size_t) {
+        const time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char buf[64];
+        sink = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+    });
+}
+
+void bench_context(const size_t n) {
+    std::cerr << "--- LOG_INFO with context fields ---" << std::endl;
+    bench("LOG_INFO without context", n, [](size_t i) {
+        LOG_INFO("x", i, "y", 3.14);
+    });
+    {
+        LOG_CONTEXT("req", 42);
+        LOG_CONTEXT("user", "alice");
+        bench("LOG_INFO with 2 context fields", n, [](size_t i) {
+            LOG_INFO("x", i, "y", 3.14);
+        });
+    }
+    bench("LOG_INFO with the same fields as arguments", n, [](size_t i) {
+        LOG_INFO("req=", 42, "user=", "alice", "x", i, "y", 3.14);
+    });
+    bench("LOG_CONTEXT enter + exit", n, [](size_t i) {
+        LOG_CONTEXT("req", i);
+    });
+}
+
+void bench_coalesce(const size_t n) {
+    std::cerr << "--- identical consecutive LOG_WARN ---" << std::endl;
+    bench("LOG_WARN written every time", n, [](size_t) {
+        LOG_WARN("link down", 42);
+    });
+    LOG_SET_COALESCE(1000);
+    bench("LOG_WARN coalesced (LOG_SET_COALESCE(1000))", n, [](size_t) {
+        LOG_WARN("link down", 42);
+    });
+    bench("LOG_WARN alternating with another record", n, [](size_t i) {
+        LOG_WARN("link", (i & 1) ? "down" : "up");
+    });
+    LOG_SET_COALESCE(0);
+}
+
+void bench_compress(const size_t n) {
+    std::cerr << "--- block compression (CompressedSink, std::cout disabled) ---" << std::endl;
+    LOG_SET_LEVEL(DebugLogLevel::LVL_NONE);
+    auto plain = std::make_shared<NullSink>();
+    uint32_t id = LOG_ADD_SINK(plain, DebugLogLevel::LVL_TRACE);
+    bench("LOG_INFO to NullSink", n, [](size_t i) {
+        LOG_INFO("sensor", i % 16, "value", 20.5 + (double)(i % 7), "state ok");
+    });
+    LOG_REMOVE_SINK(id);
+    auto packed = std::make_shared<NullSink>();
+    id = LOG_ADD_SINK(std::make_shared<DebugLog::CompressedSink>(packed), DebugLogLevel::LVL_TRACE);
+    bench("LOG_INFO to CompressedSink(NullSink)", n, [](size_t i) {
+        LOG_INFO("sensor", i % 16, "value", 20.5 + (double)(i % 7), "state ok");
+    });
+    LOG_REMOVE_SINK(id);
+    LOG_SET_LEVEL(DebugLogLevel::LVL_TRACE);
+
+    // the same records through the compressor and the decompressor only
+    std::string text;
+    for (size_t i = 0; text.size() < (64u << 20); ++i) {
+        std::ostringstream os;
+        os << "[INFO] main.cpp L." << 40 + i % 7 << " update : sensor " << i % 16 << " value " << 20.5 + (double)(i % 7) << " state ok\n";
+        text += os.str();
+    }
+    const size_t block = DEBUGLOG_COMPRESS_BLOCK_SIZE;
+    const double mb = (double)text.size() / (1 << 20);
+    std::vector<uint8_t> frames;
+    std::vector<uint8_t> frame(DebugLog::compress::FRAME_HEADER_SIZE + block);
+    std::vector<uint16_t> table(DebugLog::compress::HASH_SIZE);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < text.size(); p += block) {
+        const size_t size = std::min(block, text.size() - p);
+        const size_t m = DebugLog::compress::write_frame(reinterpret_cast<const uint8_t*>(text.data()) + p, size, frame.data(), table.data());
+        frames.insert(frames.end(), frame.begin(), frame.begin() + m);
+    }
+    const double ms_compress = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<uint8_t> raw(block);
+    size_t n_decoded = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t p = 0; p + DebugLog::compress::FRAME_HEADER_SIZE <= frames.size();) {
+        DebugLog::compress::Frame f;
+        if (!f.read(&frames[p]) || !f.decode(&frames[p + DebugLog::compress::FRAME_HEADER_SIZE], raw.data())) break;
+        n_decoded += f.raw_size;
+        p += DebugLog::compress::FRAME_HEADER_SIZE + f.stored_size;
+    }
+    const double ms_decompress = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cerr << std::fixed << std::setprecision(2)
+              << "ratio " << (plain->n_bytes ? (double)plain->n_bytes / (double)packed->n_bytes : 0.0) << " (LOG_INFO), "
+              << (double)text.size() / (double)frames.size() << " (" << (int)mb << " MB of records)" << std::endl
+              << "compress   : " << ms_compress / mb << " ms CPU per MB logged (" << mb / ms_compress * 1000 << " MB/s)" << std::endl
+              << "decompress : " << ms_decompress / mb << " ms CPU per MB logged (" << mb / ms_decompress * 1000 << " MB/s)"
+              << (n_decoded == text.size() ? "" : " FAILED") << std::endl;
+}
+
+int main() {
+    const size_t n = 1000000;
+
+    // std::cout is synchronized with stdio, so every write to std::cout is one fwrite to /dev/null
+    if (!freopen("/dev/null", "w", stdout)) return 1;
+
+    bench_preamble(n);
+    bench_line(n);
+    bench_format(n);
+    bench_filtered(n * 10);
+    bench_numbers(n / 1000);
+    bench_sinks(n);
+    bench_trace(n / 10);  // below DEBUGLOG_TRACE_MAX_EVENTS
+    bench_timestamp(n);
+    bench_context(n);
+    bench_coalesce(n);
+    bench_compress(n);
+}
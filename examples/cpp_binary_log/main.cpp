@@ -0,0 +1,32 @@
+// In binary mode, LOG_XXXX only write the call site id and raw arguments to the file
+// and the text is rebuilt later by tools/binary_log_decoder
+#define DEBUGLOG_ENABLE_BINARY_LOG
+
+// You can also set default log level by defining macro (default: INFO)
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+int main() {
+    LOG_SET_LEVEL(DebugLogLevel::LVL_TRACE);
+
+    // Until the binary file is attached, LOG_XXXX are printed as text
+    LOG_INFO("this is printed as text");
+
+    LOG_BINARY_ATTACH("log.bin");
+
+    // These are written to log.bin without formatting
+    for (int i = 0; i < 3; ++i) {
+        LOG_DEBUG("loop", i, "of", 3, 1.5 * i);
+    }
+
+    float arr[3] {1.1f, 2.2f, 3.3f};
+    std::vector<int> vs {1, 2, 3};
+    std::map<std::string, int> ms {{"one", 1}, {"two", 2}};
+    LOG_INFO("array", LOG_AS_ARR(arr, 3), "containers", vs, ms);
+
+    // PRINT and PRINTLN are always printed as text
+    PRINTLN("decode log.bin by: binary_log_decoder log.bin");
+
+    LOG_BINARY_CLOSE();
+}
@@ -0,0 +1,28 @@
+// Flight recorder: the last records at all levels are kept in memory
+// and dumped by ASSERT, LOG_DUMP_RECORDER() or a fatal signal
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+int parse(const int i) {
+    LOG_TRACE("parse", i);
+    return i * 2;
+}
+
+int main() {
+    // only WARN and ERROR are printed, but DEBUG and TRACE are also kept in the recorder
+    LOG_SET_LEVEL(DebugLogLevel::LVL_WARN);
+
+    // dump the recorder to stderr on SIGSEGV, SIGABRT etc.
+    LOG_RECORDER_HANDLE_SIGNALS();
+
+    int sum = 0;
+    for (int i = 0; i < 10; ++i) {
+        sum += parse(i);
+        LOG_DEBUG("sum", sum);
+    }
+    LOG_WARN("sum is larger than expected:", sum);
+
+    // the records above are written to std::cout before the assertion message, and then abort() is called
+    ASSERTM(sum < 50, "sum should be less than 50");
+}
@@ -0,0 +1,29 @@
+// IndexedFileSink writes records in chunks with a sparse index
+// which tools/log_search uses to skip chunks by level, time and call site
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+void motor_update(const int i) {
+    if (i % 1000 == 0) LOG_WARN("motor timeout", i);
+    LOG_TRACE("motor position", i * 10);
+}
+
+void sensor_read(const int i) {
+    LOG_DEBUG("sensor value", i % 7);
+}
+
+int main() {
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+
+    // all records (including DEBUG and TRACE) to debug.dlx (index is written when the sink is destroyed)
+    LOG_ADD_SINK(std::make_shared<DebugLog::IndexedFileSink>("debug.dlx"), DebugLogLevel::LVL_TRACE);
+
+    for (int i = 0; i < 10000; ++i) {
+        motor_update(i);
+        sensor_read(i);
+    }
+    LOG_INFO("done");
+
+    PRINTLN("search debug.dlx by: log_search -l WARN -F motor_update debug.dlx");
+}
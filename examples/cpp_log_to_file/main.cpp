@@ -0,0 +1,45 @@
+// LOG_XXXX above this level are removed at compile time
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+// You can also set default file level by defining macro (default: ERROR)
+#define DEBUGLOG_DEFAULT_FILE_LEVEL_TRACE
+
+// You can change the default size of one file and the number of rotated files
+// #define DEBUGLOG_MMAP_SEGMENT_SIZE (4 * 1024 * 1024)
+// #define DEBUGLOG_MMAP_MAX_FILES 4
+
+#include "../../DebugLog.h"
+
+#include <thread>
+#include <vector>
+
+int main() {
+    // LOG_XXXX are written to debug.log as well as std::cout
+    // debug.log is rotated every 64 KB: debug.log -> debug.log.1 -> debug.log.2
+    LOG_ATTACH_FILE("debug.log", 64 * 1024, 3);
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+
+    // LOG_FILE_SET_LEVEL() changes the level of the file independently of LOG_SET_LEVEL()
+    LOG_INFO("written to both std::cout and debug.log");
+    LOG_TRACE("written only to debug.log");
+
+    // PRINT_FILE and PRINTLN_FILE are always written to the file regardless of file_level
+    PRINTLN_FILE("file level is", (int)LOG_FILE_GET_LEVEL());
+
+    // Multiple threads can write to the file without a lock
+    LOG_SET_LEVEL(DebugLogLevel::LVL_WARN);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 1000; ++i) {
+                LOG_DEBUG("thread", t, "count", i);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    // Write dirty pages to the disk (optional, the file is also closed at exit)
+    LOG_FILE_FLUSH();
+    LOG_FILE_CLOSE();
+    LOG_WARN("file is", LOG_FILE_IS_OPEN() ? "open" : "closed");
+}
@@ -0,0 +1,141 @@
+// Many threads log concurrently while another thread changes the configuration and the sinks
+// The records are captured by a sink and checked, and the exit code is 1 if one of them is wrong
+// Build with -fsanitize=thread to check that there is no data race:
+//   g++ -std=c++11 -O1 -g -fsanitize=thread -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> main.cpp -pthread
+
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int n_threads = 8;
+const int n_logs = 2000;
+
+// checks "thread <t> hex ff" (odd threads) and "thread <t> dec 255" (even threads) of every DEBUG record,
+// and counts the records of each thread
+class CheckSink : public DebugLog::Sink {
+    std::mutex mtx;
+    std::vector<int> n_debug = std::vector<int>(n_threads, 0);
+    std::vector<int> n_async = std::vector<int>(n_threads, 0);
+    int n_errors {0};
+
+    void check(const std::string& line) {
+        const size_t p = line.find("thread");
+        if (p == std::string::npos) return;
+        const size_t d = line.find_first_of("0123456789", p);
+        const int t = (d == std::string::npos) ? -1 : std::atoi(line.c_str() + d);
+        if (t < 0 || t >= n_threads) {
+            error(line);
+        } else if (line.find("async") != std::string::npos) {
+            ++n_async[t];
+        } else if (line.find((t % 2) ? "hex" : "dec") == std::string::npos) {
+            error(line);
+        } else {
+            const std::string value = (t % 2) ? "ff" : "255";
+            if (line.compare(line.size() - value.size(), value.size(), value) != 0) error(line);
+            ++n_debug[t];
+        }
+    }
+
+    void error(const std::string& line) {
+        if (n_errors++ < 10) std::cerr << "unexpected record: " << line << std::endl;
+    }
+
+public:
+    // one or more whole records
+    void write(const char* data, const size_t size) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        const std::string records(data, size);
+        size_t begin = 0;
+        for (size_t end = records.find('\n'); end != std::string::npos; end = records.find('\n', begin)) {
+            check(records.substr(begin, end - begin));
+            begin = end + 1;
+        }
+    }
+
+    // the number of errors including the missing records
+    int errors(const bool b_async) {
+        std::lock_guard<std::mutex> lock(mtx);
+        int n = n_errors;
+        for (int t = 0; t < n_threads; ++t) {
+            const int count = b_async ? n_async[t] : n_debug[t];
+            if (count == n_logs) continue;
+            std::cerr << "thread " << t << ": " << count << " / " << n_logs << " records" << std::endl;
+            ++n;
+        }
+        return n;
+    }
+};
+
+// added and removed while logging
+class NullSink : public DebugLog::Sink {
+public:
+    void write(const char*, const size_t) override {}
+};
+
+int main() {
+    std::atomic<bool> b_done {false};
+
+    // DEBUG records are captured regardless of LOG_SET_LEVEL()
+    auto checker = std::make_shared<CheckSink>();
+    LOG_ADD_SINK(checker, DebugLogLevel::LVL_DEBUG, std::make_shared<DebugLog::PlainFormatter>());
+
+    // configuration and sinks can be changed while other threads are logging
+    std::thread config([&] {
+        int i = 0;
+        while (!b_done) {
+            LOG_SET_LEVEL((i % 2) ? DebugLogLevel::LVL_TRACE : DebugLogLevel::LVL_DEBUG);
+            LOG_SET_DELIMITER((i % 2) ? " " : ", ");
+            // every fourth sink has its own queue and thread
+            const uint32_t id = LOG_ADD_SINK(std::make_shared<NullSink>(), DebugLogLevel::LVL_TRACE, nullptr, (i % 4) ? 0 : 4096);
+            std::this_thread::yield();
+            LOG_REMOVE_SINK(id);
+            ++i;
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < n_logs; ++i) {
+                if (t % 2) {
+                    // base is kept per thread: this does not change the output of other threads
+                    LOG_DEBUG("thread", t, "hex", DebugLogBase::HEX, 255);
+                } else {
+                    LOG_DEBUG("thread", t, "dec", 255);
+                }
+                LOG_TRACE("thread", t, "trace", i);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    b_done = true;
+    config.join();
+    int n_errors = checker->errors(false);
+
+    // async mode can also be started and stopped while logging
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+    LOG_SET_DELIMITER(" ");
+    threads.clear();
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < n_logs; ++i) {
+                LOG_INFO("thread", t, "async", i);
+            }
+        });
+    }
+    LOG_ASYNC_START();
+    for (auto& th : threads) th.join();
+    LOG_ASYNC_STOP();
+    LOG_FLUSH_SINKS();
+    n_errors += checker->errors(true);
+
+    PRINTLN(n_errors ? "failed" : "done");
+    return n_errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
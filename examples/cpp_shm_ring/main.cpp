@@ -0,0 +1,39 @@
+// LOG_XXXX of several processes can be written to rings in shared memory
+// and merged into one file by tools/shm_log_collector
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <sys/wait.h>
+
+void worker(const int id) {
+    // each process has its own ring "/debuglog_example.<pid>" (no lock between processes)
+    // ShmRingMode::SHARED makes all processes write to one ring "/debuglog_example" without lock
+    auto ring = std::make_shared<DebugLog::ShmRingSink>("debuglog_example");
+    if (!ring->is_open()) {
+        LOG_ERROR("cannot create shared memory", ring->name());
+        return;
+    }
+    LOG_ADD_SINK(ring, DebugLogLevel::LVL_TRACE);
+
+    for (int i = 0; i < 3; ++i) {
+        LOG_INFO("worker", id, "step", i);
+    }
+
+    // the records already written are kept in the ring even if the process crashes
+    if (id == 2) abort();
+}
+
+int main() {
+    // fork before LOG_XXXX is used in this process
+    for (int id = 0; id < 3; ++id) {
+        if (fork() == 0) {
+            worker(id);
+            return 0;
+        }
+    }
+    while (wait(nullptr) > 0)
+        ;
+
+    PRINTLN("merge the rings by: shm_log_collector -1 -u -p \"debuglog_example.*\"");
+}
@@ -0,0 +1,44 @@
+// LOG_XXXX can be written to any number of sinks in addition to std::cout
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <chrono>
+#include <thread>
+
+// any output can be a sink: write() receives one or more whole records
+class SlowSink : public DebugLog::Sink {
+public:
+    void write(const char* data, const size_t size) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));  // e.g. network
+        std::cerr.write(data, size);
+    }
+};
+
+int main() {
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+
+    // all records (including DEBUG and TRACE) to the file as JSON lines
+    auto json = std::make_shared<DebugLog::JsonFormatter>();
+    LOG_ADD_SINK(std::make_shared<DebugLog::FileSink>("sinks.jsonl"), DebugLogLevel::LVL_TRACE, json);
+
+    // WARN and ERROR to std::cerr without the level tag
+    LOG_ADD_SINK(std::make_shared<DebugLog::OstreamSink>(std::cerr), DebugLogLevel::LVL_WARN, std::make_shared<DebugLog::PlainFormatter>());
+
+    // a slow sink gets its own queue (64 KB) and thread, so it does not block LOG_XXXX
+    const uint32_t slow = LOG_ADD_SINK(std::make_shared<SlowSink>(), DebugLogLevel::LVL_ERROR, nullptr, 64 * 1024);
+
+    LOG_ERROR("this is error log");
+    LOG_WARN("this is warn log");
+    LOG_INFO("this is info log");
+    LOG_DEBUG("this is debug log (only in sinks.jsonl)");
+    LOG_TRACE("this is trace log (only in sinks.jsonl)");
+
+    // the level of each sink can be changed at runtime
+    LOG_SET_SINK_LEVEL(slow, DebugLogLevel::LVL_INFO);
+    LOG_INFO("this is info log (also to the slow sink)");
+
+    // queued records are written before the sink is removed
+    LOG_REMOVE_SINK(slow);
+    LOG_FLUSH_SINKS();
+}
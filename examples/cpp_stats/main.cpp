@@ -0,0 +1,39 @@
+// Counters and latency histograms of DebugLog itself
+// they are recorded only if DEBUGLOG_ENABLE_STATS is defined (otherwise the hooks are compiled out)
+#define DEBUGLOG_ENABLE_STATS
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+int main() {
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+
+    // "[INFO] DebugLog stats : ..." is written every 100 ms while logging
+    LOG_SET_STATS_REPORT_INTERVAL(100);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 50; ++i) {
+                LOG_INFO("thread", t, "count", i);
+                LOG_DEBUG("filtered by the runtime log level");
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    LOG_SET_STATS_REPORT_INTERVAL(0);
+
+    // the snapshot is the sum of the counters of all threads
+    const DebugLog::StatsSnapshot s = LOG_GET_STATS();
+    PRINTLN("INFO records :", s.records[(size_t)DebugLogLevel::LVL_INFO]);
+    PRINTLN("filtered     :", s.filtered);
+    PRINTLN("bytes        :", s.stream_bytes);
+    PRINTLN("log() ns     : p50", s.log_ns.percentile(0.5), "p99", s.log_ns.percentile(0.99), "max", s.log_ns.max);
+    PRINTLN("write ns     : p50", s.write_ns.percentile(0.5), "p99", s.write_ns.percentile(0.99), "max", s.write_ns.max);
+    PRINTLN(s.summary());
+}
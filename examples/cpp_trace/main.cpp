@@ -0,0 +1,46 @@
+// Scoped timing and trace events exported as Chrome trace event JSON
+// open trace.json in chrome://tracing or https://ui.perfetto.dev
+// LOG_SCOPE and LOG_TRACE_BEGIN / END are compiled out unless the compile-time log level is TRACE
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include "../../DebugLog.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+void parse(const int i) {
+    LOG_SCOPE("parse");
+    std::this_thread::sleep_for(std::chrono::microseconds(200 + 50 * i));
+}
+
+void work(const int t) {
+    LOG_SCOPE("work");
+    for (int i = 0; i < 5; ++i) parse(i);
+
+    // begin and end can be in different scopes, and should be nested within the thread
+    LOG_TRACE_BEGIN("flush");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1 + t));
+    LOG_TRACE_END("flush");
+}
+
+int main() {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) threads.emplace_back(work, t);
+    for (auto& th : threads) th.join();
+
+    {
+        LOG_SCOPE("main");
+        work(0);
+    }
+
+    if (LOG_TRACE_EXPORT("trace.json"))
+        LOG_INFO("trace events are written to trace.json");
+    else
+        LOG_ERROR("failed to open trace.json");
+
+    // the exported events are discarded, and the buffers of the exited threads are reused by new threads
+    LOG_TRACE_CLEAR();
+    std::thread(work, 3).join();
+    LOG_TRACE_EXPORT(std::cout);
+}
@@ -0,0 +1,34 @@
+// You can also set default log level by defining macro (default: INFO)
+// #define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+
+#include <DebugLog.h>
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+
+    // 1st, 11th, 21st ... calls are printed
+    for (int i = 0; i < 30; ++i) {
+        LOG_WARN_EVERY_N(10, "every 10 calls:", i);
+    }
+
+    // only the first 3 calls are printed
+    for (int i = 0; i < 30; ++i) {
+        LOG_INFO_FIRST_N(3, "first 3 calls:", i);
+    }
+}
+
+void loop() {
+    static int count = 0;
+    ++count;
+
+    // at most once per second, with the number of suppressed messages
+    // e.g. "[INFO] rate_limit.ino L.27 loop : every second: 12345 (suppressed 9876 messages)"
+    LOG_INFO_EVERY_MS(1000, "every second:", count);
+
+    // token bucket: 2 messages per second on average, and 5 messages at once
+    LOG_WARN_RATE(2, 5, "token bucket:", count);
+
+    // the arguments are not evaluated if the message is suppressed
+    LOG_ERROR_EVERY_N(100000, "millis() is called only when printed:", millis());
+}
@@ -0,0 +1,232 @@
+// Minimal host mock of the Arduino core and a file system
+// to run and benchmark the Arduino code path of DebugLog on Linux / macOS
+//
+// Serial discards the output, and MockFS keeps files in memory.
+// Each File counts write() / flush() calls, and write() / flush() can be slowed down
+// to simulate the latency of SD cards or flash memory.
+// This header defines global objects, so include it from only one translation unit.
+
+#pragma once
+#ifndef DEBUGLOG_ARDUINO_MOCK_H
+#define DEBUGLOG_ARDUINO_MOCK_H
+
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+#define FILE_READ "r"
+#define FILE_WRITE "a"
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const auto t0 = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - t0).count();
+}
+inline unsigned long millis() { return micros() / 1000; }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void yield() {}
+
+class String {
+    std::string s;
+
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& c) : s(c) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int v) : s(std::to_string(v)) {}
+    explicit String(unsigned int v) : s(std::to_string(v)) {}
+    explicit String(long v) : s(std::to_string(v)) {}
+    explicit String(unsigned long v) : s(std::to_string(v)) {}
+    explicit String(double v) : s(std::to_string(v)) {}
+
+    unsigned int length() const { return (unsigned int)s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    void reserve(unsigned int n) { s.reserve(n); }
+    char operator[](unsigned int i) const { return s[i]; }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char o) { s += o; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const String& a, int b) { return String(a.s + std::to_string(b)); }
+    bool operator<(const String& o) const { return s < o.s; }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator!=(const String& o) const { return s != o.s; }
+};
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+    size_t print_number(unsigned long n, int base) {
+        char buf[8 * sizeof(long) + 1];
+        char* p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        if (base < 2) base = 10;
+        do {
+            const int d = (int)(n % base);
+            n /= base;
+            *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+        } while (n);
+        return write(p);
+    }
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) {
+        size_t r = 0;
+        while (n--) r += write(*b++);
+        return r;
+    }
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char s[]) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int b = DEC) { return print((unsigned long)v, b); }
+    size_t print(int v, int b = DEC) { return print((long)v, b); }
+    size_t print(unsigned int v, int b = DEC) { return print((unsigned long)v, b); }
+    size_t print(long v, int b = DEC) {
+        if (b == DEC && v < 0) return print('-') + print_number((unsigned long)-v, DEC);
+        return print_number((unsigned long)v, b);
+    }
+    size_t print(unsigned long v, int b = DEC) { return print_number(v, b); }
+    size_t print(double v, int digits = 2) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        return write(buf);
+    }
+    size_t print(const Printable& x) { return x.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T& v, int b) { return print(v, b) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+// discards the output (only the number of bytes is counted)
+class HardwareSerial : public Stream {
+public:
+    size_t n_bytes {0};
+
+    void begin(unsigned long) {}
+    size_t write(uint8_t) override { ++n_bytes; return 1; }
+    size_t write(const uint8_t*, size_t n) override { n_bytes += n; return n; }
+    using Print::write;
+    int availableForWrite() override { return 64; }
+    operator bool() const { return true; }
+};
+
+static HardwareSerial Serial;
+
+// content and statistics of one file in MockFS
+struct MockStorage {
+    std::string data;
+    size_t n_durable {0};       // bytes which were flushed to the media
+    size_t n_write_calls {0};   // write() calls from Print
+    size_t n_flushes {0};
+    unsigned long write_latency_us {0};  // busy wait in every write()
+    unsigned long flush_latency_us {0};  // busy wait in every flush()
+};
+
+inline void busy_wait_us(const unsigned long us) {
+    const unsigned long begin = micros();
+    while (micros() - begin < us)
+        ;
+}
+
+class File : public Stream {
+    MockStorage* storage {nullptr};
+
+public:
+    File() {}
+    explicit File(MockStorage* s) : storage(s) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* b, size_t n) override {
+        if (!storage) return 0;
+        ++storage->n_write_calls;
+        if (storage->write_latency_us) busy_wait_us(storage->write_latency_us);
+        storage->data.append((const char*)b, n);
+        return n;
+    }
+    using Print::write;
+
+    void flush() override {
+        if (!storage) return;
+        ++storage->n_flushes;
+        if (storage->flush_latency_us) busy_wait_us(storage->flush_latency_us);
+        storage->n_durable = storage->data.size();
+    }
+
+    void close() {
+        flush();
+        storage = nullptr;
+    }
+
+    size_t size() const { return storage ? storage->data.size() : 0; }
+    operator bool() const { return storage != nullptr; }
+};
+
+// in-memory file system which has the same interface as SD / SdFat / LittleFS for DebugLog
+class MockFS {
+    std::map<std::string, MockStorage> files;
+
+public:
+    unsigned long write_latency_us {0};  // applied to files opened after this is set
+    unsigned long flush_latency_us {0};  // applied to files opened after this is set
+
+    bool begin() { return true; }
+
+    File open(const char* path, const char* mode = FILE_READ) {
+        MockStorage& s = files[path];
+        if (strcmp(mode, FILE_WRITE) != 0 && strcmp(mode, FILE_READ) != 0) s.data.clear();
+        s.write_latency_us = write_latency_us;
+        s.flush_latency_us = flush_latency_us;
+        return File(&s);
+    }
+
+    bool exists(const char* path) const { return files.find(path) != files.end(); }
+    bool remove(const char* path) { return files.erase(path) != 0; }
+
+    MockStorage& storage(const char* path) { return files[path]; }
+};
+
+#endif  // DEBUGLOG_ARDUINO_MOCK_H
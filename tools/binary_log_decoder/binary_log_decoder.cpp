@@ -0,0 +1,32 @@
+// Decodes the binary log written with DEBUGLOG_ENABLE_BINARY_LOG into the text
+// which LOG_XXXX would have printed
+//
+// build : g++ -std=c++11 -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> binary_log_decoder.cpp -o binary_log_decoder
+// usage : binary_log_decoder log.bin > log.txt
+
+#include <ArxTypeTraits.h>
+#include <ArxContainer.h>
+#include <fstream>
+#include <iostream>
+
+#include "../../DebugLog/BinaryLog.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <binary log file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream ifs(argv[1], std::ios::binary);
+    if (!ifs) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    arx::debug::BinaryLogDecoder decoder(ifs);
+    if (!decoder.decode(std::cout)) {
+        std::cerr << "invalid or truncated binary log: " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Checks and benchmarks the auto save policy and the throughput of the Arduino file logger on host
+// with the mock Arduino core and the in-memory file system in tools/arduino_mock
+//
+// build : g++ -std=gnu++11 -O2 -I../arduino_mock -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> file_logger_benchmark.cpp -o file_logger_benchmark
+// usage : file_logger_benchmark [flush latency in us (default: 200)] [write latency in us (default: 5)]
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+static MockFS fs;
+
+#define DEBUGLOG_DEFAULT_LOG_LEVEL_TRACE
+#define DEBUGLOG_DEFAULT_FILE_LEVEL_INFO
+#define DEBUGLOG_ENABLE_FILE_LOGGER
+#include "../../DebugLog.h"
+
+static int n_failed = 0;
+
+static void check(const char* name, const bool b) {
+    printf("%-56s %s\n", name, b ? "ok" : "FAILED");
+    if (!b) ++n_failed;
+}
+
+static MockStorage& reopen(const char* path) {
+    fs.remove(path);
+    LOG_ATTACH_FS_AUTO(fs, path, FILE_WRITE);
+    return fs.storage(path);
+}
+
+static void check_policy() {
+    printf("--- auto save policy ---\n");
+    LOG_SET_LEVEL(DebugLogLevel::LVL_NONE);  // file output only
+
+    LOG_FILE_SET_FLUSH_POLICY(0, 4, 0);
+    MockStorage& r = reopen("/records.txt");
+    for (int i = 0; i < 3; ++i) LOG_INFO("record", i);
+    check("records: not flushed before 4 records", r.n_flushes == 0);
+    LOG_INFO("record", 3);
+    check("records: flushed at 4 records", r.n_flushes == 1 && r.n_durable == r.data.size());
+
+    LOG_FILE_SET_FLUSH_POLICY(64, 0, 0);
+    MockStorage& b = reopen("/bytes.txt");
+    LOG_INFO("short");
+    check("bytes: not flushed before 64 bytes", b.n_flushes == 0);
+    LOG_INFO("long enough record to exceed the threshold of 64 bytes");
+    check("bytes: flushed after 64 bytes", b.n_flushes == 1 && b.n_durable == b.data.size());
+
+    LOG_FILE_SET_FLUSH_POLICY(0, 0, 20);
+    MockStorage& t = reopen("/interval.txt");
+    LOG_INFO("first");
+    check("interval: not flushed before 20 ms", t.n_flushes == 0);
+    delay(25);
+    LOG_INFO("second");
+    check("interval: flushed by the next record after 20 ms", t.n_flushes == 1);
+
+    LOG_FILE_SET_FLUSH_POLICY(0, 0, 0);
+    MockStorage& e = reopen("/error.txt");
+    LOG_WARN("warning is buffered");
+    check("error: warning is not flushed", e.n_flushes == 0);
+    LOG_ERROR("error is flushed immediately");
+    check("error: flushed immediately", e.n_flushes == 1 && e.n_durable == e.data.size());
+
+    LOG_FILE_CLOSE();
+    LOG_FILE_SET_FLUSH_POLICY();
+    LOG_SET_LEVEL(DebugLogLevel::LVL_TRACE);
+}
+
+// baseline: the file is attached as the stream, so every token is written to the file (and flushed per record)
+static void bench_unbuffered(const char* name, const int n, const bool b_flush) {
+    fs.remove("/bench.txt");
+    File file = fs.open("/bench.txt", FILE_WRITE);
+    MockStorage& s = fs.storage("/bench.txt");
+    LOG_ATTACH_STREAM(file);
+    LOG_SET_LEVEL(DebugLogLevel::LVL_INFO);
+    const unsigned long begin = micros();
+    for (int i = 0; i < n; ++i) {
+        LOG_INFO("sensor", i, "value", 1.5 * i, "status", "ok");
+        if (b_flush) file.flush();
+    }
+    const unsigned long elapsed = micros() - begin;
+    LOG_SET_LEVEL(DebugLogLevel::LVL_NONE);
+    LOG_ATTACH_STREAM(Serial);
+    file.close();
+    printf("%-40s %8.0f records/s %6.2f write calls/record\n", name, n * 1e6 / (elapsed ? elapsed : 1), (double)s.n_write_calls / n);
+}
+
+static void bench_throughput(const char* name, const int n) {
+    DebugLog::Manager::get().file_flush_policy(DebugLog::FlushPolicy(0, 0, 0));
+    MockStorage& s = reopen("/bench.txt");
+    const unsigned long begin = micros();
+    for (int i = 0; i < n; ++i) LOG_INFO("sensor", i, "value", 1.5 * i, "status", "ok");
+    LOG_FILE_CLOSE();
+    const unsigned long elapsed = micros() - begin;
+    printf("%-40s %8.0f records/s %6.2f write calls/record\n", name, n * 1e6 / (elapsed ? elapsed : 1), (double)s.n_write_calls / n);
+}
+
+static void bench(const char* name, const DebugLog::FlushPolicy& policy, const int n) {
+    DebugLog::Manager::get().file_flush_policy(policy);
+    MockStorage& s = reopen("/bench.txt");
+    const unsigned long begin = micros();
+    for (int i = 0; i < n; ++i) LOG_INFO("sensor", i, "value", 1.5 * i, "status", "ok");
+    const unsigned long elapsed = micros() - begin;
+    LOG_FILE_CLOSE();
+    printf("%-40s %8.0f records/s %6zu flushes %6.1f bytes/flush\n", name, n * 1e6 / (elapsed ? elapsed : 1), s.n_flushes,
+        (double)s.data.size() / (s.n_flushes ? s.n_flushes : 1));
+}
+
+int main(int argc, char** argv) {
+    const unsigned long flush_latency_us = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 200;
+    const unsigned long write_latency_us = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 5;
+
+    check_policy();
+
+    const int n = 5000;
+    LOG_SET_LEVEL(DebugLogLevel::LVL_NONE);  // measure the file output only
+    printf("--- %d records, no auto flush ---\n", n);
+    bench_unbuffered("unbuffered per token (baseline)", n, false);
+    bench_throughput("formatting only (no latency)", n);
+    fs.write_latency_us = write_latency_us;
+    printf("--- %d records, %lu us per write call, no auto flush ---\n", n, fs.write_latency_us);
+    bench_unbuffered("unbuffered per token (baseline)", n, false);
+    bench_throughput("write latency", n);
+
+    fs.flush_latency_us = flush_latency_us;
+    printf("--- %d records, %lu us per flush ---\n", n, fs.flush_latency_us);
+    bench_unbuffered("unbuffered per token, flush per record", n, true);
+    bench("flush per record (buffered)", DebugLog::FlushPolicy(0, 1, 0), n);
+    bench("group commit (default)", DebugLog::FlushPolicy(), n);
+    bench("group commit (4096 bytes)", DebugLog::FlushPolicy(4096, 0, 1000), n);
+    bench("no auto flush (manual)", DebugLog::FlushPolicy(0, 0, 0), n);
+
+    return n_failed ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+// Decompresses the log written with DEBUGLOG_ENABLE_FILE_COMPRESSION or DebugLog::CompressedSink
+// into the text which LOG_XXXX printed
+//
+// build : g++ -std=c++11 -O2 -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> log_decompressor.cpp -o log_decompressor
+// usage : log_decompressor log.dlz > log.txt
+//
+// a truncated frame at the end (e.g. power loss) is ignored,
+// and a corrupted frame is skipped up to the next frame header (reported to stderr)
+
+#include <ArxTypeTraits.h>
+#include <ArxContainer.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../../DebugLog/Compress.h"
+
+using namespace arx::debug::compress;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <compressed log file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream ifs(argv[1], std::ios::binary);
+    if (!ifs) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    std::vector<uint8_t> raw(MAX_BLOCK_SIZE);
+    size_t pos = 0;
+    size_t n_skipped = 0;
+    bool b_truncated = false;
+    while (pos + FRAME_HEADER_SIZE <= data.size()) {
+        Frame f;
+        if (f.read(&data[pos])) {
+            if (pos + FRAME_HEADER_SIZE + f.stored_size > data.size()) {
+                b_truncated = true;
+                break;
+            }
+            if (f.decode(&data[pos + FRAME_HEADER_SIZE], raw.data())) {
+                std::cout.write(reinterpret_cast<const char*>(raw.data()), f.raw_size);
+                pos += FRAME_HEADER_SIZE + f.stored_size;
+                continue;
+            }
+        }
+        // search the next frame
+        ++n_skipped;
+        ++pos;
+        while (pos + 2 <= data.size() && !(data[pos] == 'D' && data[pos + 1] == 'Z')) ++pos;
+    }
+    if (pos < data.size() && !b_truncated && pos + FRAME_HEADER_SIZE > data.size()) b_truncated = true;
+    std::cout.flush();
+
+    if (n_skipped) std::cerr << argv[1] << ": skipped corrupted data at " << n_skipped << " positions" << std::endl;
+    if (b_truncated) std::cerr << argv[1] << ": the last frame is truncated (" << (data.size() - pos) << " bytes)" << std::endl;
+    return n_skipped ? 1 : 0;
+}
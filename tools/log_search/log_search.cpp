@@ -0,0 +1,265 @@
+// Searches the indexed log written by DebugLog::IndexedFileSink in parallel
+// and prints the matched records as the plain text which LOG_XXXX printed
+//
+// build : g++ -std=c++11 -O2 -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> log_search.cpp -o log_search -pthread
+// usage : log_search [options] <indexed log file>
+//
+//   -l LEVEL : records up to LEVEL (ERROR, WARN, INFO, DEBUG, TRACE)
+//   -a TIME  : records at or after TIME
+//   -b TIME  : records before TIME
+//   -f FILE  : records logged in FILE of LOG_PREAMBLE ("*" is a wildcard)
+//   -F FUNC  : records logged in the function FUNC ("*" is a wildcard)
+//   -s TEXT  : records which contain TEXT
+//   -t       : prefix each record with the time when it was written (UTC)
+//   -j N     : number of threads (default: number of cores)
+//   -o FILE  : output file (default: stdout)
+//   -i       : print the index of the chunks instead of the records
+//   -v       : print the number of chunks skipped by the index to stderr
+//
+//   TIME is seconds since the epoch (e.g. 1760783696.5) or UTC (e.g. 2026-10-18T10:34:56.5)
+//   e.g. log_search -l WARN -a 2026-10-18T10:00:00 -f Motor.h -s timeout debug.dlx > timeout.log
+
+#include <ArxTypeTraits.h>
+#include <ArxContainer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "../../DebugLog/IndexedLog.h"
+
+using namespace arx::debug;
+
+namespace {
+
+struct Query {
+    int max_level {(int)LogLevel::LVL_NONE};  // LVL_NONE: no filter
+    uint64_t after {0};
+    uint64_t before {~0ull};
+    std::string file;
+    std::string func;
+    std::string text;
+    bool b_time {false};
+
+    bool rules_out(const indexed::Chunk& c) const {
+        if (max_level != (int)LogLevel::LVL_NONE && !(c.level_mask & ((2u << max_level) - 2u))) return true;
+        if (c.n_records == 0 || c.t_max < after || c.t_min >= before) return true;
+        if (!file.empty() && file.find('*') == std::string::npos && !c.may_have_site("file:", file)) return true;
+        if (!func.empty() && func.find('*') == std::string::npos && !c.may_have_site("func:", func)) return true;
+        return false;
+    }
+
+    bool matches(const uint64_t time_ns, const LogLevel level, const char* data, const size_t size) const {
+        if (max_level != (int)LogLevel::LVL_NONE && (level == LogLevel::LVL_NONE || (int)level > max_level)) return false;
+        if (time_ns < after || time_ns >= before) return false;
+        if (!file.empty() || !func.empty()) {
+            const indexed::RecordInfo info = indexed::parse_record(data, size);
+            if (!info.file) return false;
+            if (!file.empty() && !glob(file.c_str(), info.file, info.file + info.file_size)) return false;
+            if (!func.empty() && !glob(func.c_str(), info.func, info.func + info.func_size)) return false;
+        }
+        return text.empty() || std::search(data, data + size, text.begin(), text.end()) != data + size;
+    }
+
+    static bool glob(const char* p, const char* s, const char* end) {
+        if (*p == '\0') return s == end;
+        if (*p == '*') return glob(p + 1, s, end) || (s != end && glob(p, s + 1, end));
+        return s != end && *s == *p && glob(p + 1, s + 1, end);
+    }
+};
+
+// days since 1970-01-01 of the proleptic Gregorian calendar
+int64_t days_from_civil(int64_t y, const int64_t m, const int64_t d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+bool parse_time(const char* s, uint64_t& ns) {
+    int y, mo, d, h, mi;
+    double sec;
+    char t;
+    if (sscanf(s, "%d-%d-%d%c%d:%d:%lf", &y, &mo, &d, &t, &h, &mi, &sec) == 7 && (t == 'T' || t == ' ')) {
+        const int64_t s0 = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60;
+        ns = (uint64_t)(s0 * 1000000000ll + (int64_t)(sec * 1e9));
+        return true;
+    }
+    char* end;
+    const double v = strtod(s, &end);
+    if (end == s || *end != '\0' || v < 0) return false;
+    ns = (uint64_t)(v * 1e9);
+    return true;
+}
+
+std::string format_time(const uint64_t ns) {
+    const int64_t secs = (int64_t)(ns / 1000000000ull);
+    int64_t z = secs / 86400 + 719468;
+    const int64_t era = z / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int64_t d = doy - (153 * mp + 2) / 5 + 1;
+    const int64_t m = mp + (mp < 10 ? 3 : -9);
+    const int64_t y = yoe + era * 400 + (m <= 2);
+    const int64_t sod = secs % 86400;
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02d.%06d", (int)y, (int)m, (int)d, (int)(sod / 3600), (int)(sod / 60 % 60), (int)(sod % 60), (int)(ns % 1000000000ull / 1000));
+    return buf;
+}
+
+int parse_level(const std::string& s) {
+    for (int l = (int)LogLevel::LVL_ERROR; l <= (int)LogLevel::LVL_TRACE; ++l)
+        if (s == level_name((LogLevel)l)) return l;
+    return -1;
+}
+
+void print_index(std::ostream& os, const std::vector<indexed::Chunk>& chunks) {
+    for (const auto& c : chunks) {
+        os << "offset " << c.offset << " records " << c.n_records << " bytes " << c.payload_size << " levels";
+        for (int l = (int)LogLevel::LVL_NONE; l <= (int)LogLevel::LVL_TRACE; ++l)
+            if (c.level_mask & (1u << l)) os << " " << level_name((LogLevel)l);
+        if (c.n_records) os << " time " << format_time(c.t_min) << " - " << format_time(c.t_max);
+        os << "\n";
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Query q;
+    std::string path, output;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool b_index = false, b_verbose = false;
+    bool b_usage = false;
+    for (int i = 1; i < argc && !b_usage; ++i) {
+        const std::string a = argv[i];
+        const bool b_value = (a == "-l" || a == "-a" || a == "-b" || a == "-f" || a == "-F" || a == "-s" || a == "-j" || a == "-o");
+        if (b_value && i + 1 == argc)
+            b_usage = true;
+        else if (a == "-l")
+            b_usage = (q.max_level = parse_level(argv[++i])) < 0;
+        else if (a == "-a")
+            b_usage = !parse_time(argv[++i], q.after);
+        else if (a == "-b")
+            b_usage = !parse_time(argv[++i], q.before);
+        else if (a == "-f")
+            q.file = argv[++i];
+        else if (a == "-F")
+            q.func = argv[++i];
+        else if (a == "-s")
+            q.text = argv[++i];
+        else if (a == "-j")
+            jobs = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "-o")
+            output = argv[++i];
+        else if (a == "-t")
+            q.b_time = true;
+        else if (a == "-i")
+            b_index = true;
+        else if (a == "-v")
+            b_verbose = true;
+        else if (a.empty() || a[0] == '-' || !path.empty())
+            b_usage = true;
+        else
+            path = a;
+    }
+    if (b_usage || path.empty()) {
+        std::cerr << "usage: " << argv[0] << " [-l LEVEL] [-a TIME] [-b TIME] [-f FILE] [-F FUNC] [-s TEXT] [-t] [-j N] [-o FILE] [-i] [-v] <indexed log file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream ifs(path, std::ios::binary);
+    std::vector<indexed::Chunk> chunks;
+    bool b_has_index = false;
+    if (!ifs || !indexed::read_index(ifs, chunks, b_has_index)) {
+        std::cerr << "cannot open the indexed log: " << path << std::endl;
+        return 1;
+    }
+    if (!b_has_index) std::cerr << path << ": no index (the file was not closed), " << chunks.size() << " chunks are found by scanning" << std::endl;
+
+    std::ofstream ofs;
+    if (!output.empty()) {
+        ofs.open(output, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            std::cerr << "cannot open " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& os = output.empty() ? std::cout : ofs;
+
+    if (b_index) {
+        print_index(os, chunks);
+        return 0;
+    }
+
+    std::vector<indexed::Chunk> targets;
+    for (const auto& c : chunks)
+        if (!q.rules_out(c)) targets.push_back(c);
+    if (b_verbose) std::cerr << "chunks: " << chunks.size() << ", skipped by index: " << (chunks.size() - targets.size()) << std::endl;
+
+    // chunks are scanned by the threads and written in the order of the file
+    // (up to `window` chunks are held in memory)
+    const size_t n = targets.size();
+    const size_t window = jobs * 4;
+    std::vector<std::string> results(n);
+    std::vector<char> done(n, 0);
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t next = 0, written = 0;
+    std::atomic<bool> b_corrupted {false};
+
+    auto worker = [&] {
+        std::ifstream is(path, std::ios::binary);
+        std::string payload;
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return next >= n || next < written + window; });
+                if (next >= n) return;
+                i = next++;
+            }
+            std::string out;
+            const bool b_ok = indexed::read_payload(is, targets[i], payload)
+                && indexed::for_each_record(payload, [&](const uint64_t time_ns, const LogLevel level, const char* data, const size_t size) {
+                       if (!q.matches(time_ns, level, data, size)) return;
+                       if (q.b_time) out += format_time(time_ns) + " ";
+                       out.append(data, size);
+                   });
+            if (!b_ok) b_corrupted = true;
+            std::lock_guard<std::mutex> lock(mtx);
+            results[i].swap(out);
+            done[i] = 1;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(jobs, n); ++i) threads.emplace_back(worker);
+    for (size_t i = 0; i < n; ++i) {
+        std::string out;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return done[i] != 0; });
+            out.swap(results[i]);
+            written = i + 1;
+            cv.notify_all();
+        }
+        os.write(out.data(), (std::streamsize)out.size());
+    }
+    for (auto& t : threads) t.join();
+    os.flush();
+
+    if (b_corrupted) {
+        std::cerr << "corrupted chunks in " << path << std::endl;
+        return 1;
+    }
+}
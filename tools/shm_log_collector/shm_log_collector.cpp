@@ -0,0 +1,208 @@
+// Drains the shared memory rings written by DebugLog::ShmRingSink
+// and writes the records of all processes to one file in the order of their timestamps
+//
+// build : g++ -std=c++11 -I<path/to/ArxTypeTraits> -I<path/to/ArxContainer> shm_log_collector.cpp -o shm_log_collector -pthread (-lrt on old glibc)
+// usage : shm_log_collector [-o file] [-i poll ms] [-w merge window ms] [-s stall ms] [-p] [-u] [-1] <ring name | prefix*> ...
+//
+//   -o : output file (default: stdout)
+//   -i : interval to poll the rings (default: 10 ms)
+//   -w : records are held for this time to be merged with those of other rings (default: 100 ms)
+//   -s : slot reserved but not written for this time is skipped as its producer crashed (default: 1000 ms)
+//   -p : prefix each line with "[pid] "
+//   -u : remove the ring of the process which has exited after it is drained
+//   -1 : drain the rings once and exit (e.g. to recover the records after a crash)
+//
+//   "prefix*" matches every ring whose name begins with prefix, including those created later (Linux)
+//   e.g. shm_log_collector -o all.log -u "myapp.*"   for ShmRingSink("myapp") in each process
+
+#include <ArxTypeTraits.h>
+#include <ArxContainer.h>
+#include <dirent.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "../../DebugLog/ShmRing.h"
+
+using arx::debug::shm_ring::Ring;
+
+namespace {
+
+volatile sig_atomic_t b_stop = 0;
+
+void on_signal(int) {
+    b_stop = 1;
+}
+
+struct Options {
+    std::string output;
+    uint64_t interval_ms {10};
+    uint64_t window_ms {100};
+    uint64_t stall_ms {1000};
+    bool b_pid {false};
+    bool b_unlink {false};
+    bool b_once {false};
+    std::vector<std::string> names;
+};
+
+struct Source {
+    std::unique_ptr<Ring> ring;
+    uint64_t dropped {0};
+};
+
+struct Entry {
+    uint64_t time_ns;
+    uint64_t order;  // keeps the order of the records with the same timestamp
+    uint32_t pid;
+    std::string text;
+
+    bool operator<(const Entry& e) const {
+        return (time_ns != e.time_ns) ? time_ns < e.time_ns : order < e.order;
+    }
+};
+
+bool is_alive(const uint32_t pid) {
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+}
+
+// names of the rings given by the arguments ("prefix*" is expanded with /dev/shm)
+std::vector<std::string> find_rings(const std::vector<std::string>& names) {
+    std::vector<std::string> found;
+    for (const auto& n : names) {
+        const std::string name = arx::debug::shm_ring::shm_name(n);
+        if (name.back() != '*') {
+            found.push_back(name);
+            continue;
+        }
+        const std::string prefix = name.substr(1, name.size() - 2);
+        DIR* dir = opendir("/dev/shm");
+        if (!dir) continue;
+        while (const dirent* e = readdir(dir))
+            if (std::string(e->d_name).compare(0, prefix.size(), prefix) == 0) found.push_back("/" + std::string(e->d_name));
+        closedir(dir);
+    }
+    return found;
+}
+
+void write_entry(std::ostream& os, const Entry& e, const bool b_pid) {
+    if (!b_pid) {
+        os.write(e.text.data(), (std::streamsize)e.text.size());
+        return;
+    }
+    // one chunk can contain several records (e.g. from the queue of an async sink)
+    size_t begin = 0;
+    while (begin < e.text.size()) {
+        size_t end = e.text.find('\n', begin);
+        end = (end == std::string::npos) ? e.text.size() : end + 1;
+        os << "[" << e.pid << "] ";
+        os.write(e.text.data() + begin, (std::streamsize)(end - begin));
+        begin = end;
+    }
+}
+
+bool parse(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const bool b_value = (a == "-o" || a == "-i" || a == "-w" || a == "-s");
+        if (b_value && i + 1 == argc) return false;
+        if (a == "-o")
+            opt.output = argv[++i];
+        else if (a == "-i")
+            opt.interval_ms = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "-w")
+            opt.window_ms = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "-s")
+            opt.stall_ms = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "-p")
+            opt.b_pid = true;
+        else if (a == "-u")
+            opt.b_unlink = true;
+        else if (a == "-1")
+            opt.b_once = true;
+        else if (!a.empty() && a[0] == '-')
+            return false;
+        else
+            opt.names.push_back(a);
+    }
+    return !opt.names.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " [-o file] [-i poll ms] [-w merge window ms] [-s stall ms] [-p] [-u] [-1] <ring name | prefix*> ..." << std::endl;
+        return 1;
+    }
+
+    std::ofstream ofs;
+    if (!opt.output.empty()) {
+        ofs.open(opt.output, std::ios::app | std::ios::binary);
+        if (!ofs) {
+            std::cerr << "cannot open " << opt.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& os = opt.output.empty() ? std::cout : ofs;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    std::map<std::string, Source> sources;
+    std::vector<Entry> pending;
+    std::string buf;
+    uint64_t order = 0;
+    const uint64_t stall_ns = opt.stall_ms * 1000000ull;
+    const uint64_t window_ns = opt.window_ms * 1000000ull;
+
+    while (true) {
+        const bool b_last = b_stop || opt.b_once;
+
+        for (const auto& name : find_rings(opt.names)) {
+            if (sources.count(name)) continue;
+            std::unique_ptr<Ring> ring(new Ring());
+            if (ring->open(name)) sources[name].ring = std::move(ring);
+        }
+
+        for (auto it = sources.begin(); it != sources.end();) {
+            Ring& ring = *it->second.ring;
+            const size_t skipped = ring.drain([&](const uint64_t time_ns, const uint32_t pid, const char* data, const size_t size) {
+                pending.push_back(Entry {time_ns, order++, pid, std::string(data, size)});
+            },
+                b_last ? 0 : stall_ns, buf);
+            if (skipped) std::cerr << it->first << ": skipped " << skipped << " slots not written by their producer" << std::endl;
+
+            const uint64_t dropped = ring.header().dropped.load(std::memory_order_relaxed);
+            if (dropped != it->second.dropped) {
+                std::cerr << it->first << ": " << (dropped - it->second.dropped) << " records dropped because the ring was full" << std::endl;
+                it->second.dropped = dropped;
+            }
+
+            const uint32_t owner = ring.header().owner_pid;
+            if (opt.b_unlink && owner != 0 && !is_alive(owner) && ring.empty()) {
+                shm_unlink(it->first.c_str());
+                it = sources.erase(it);
+            } else
+                ++it;
+        }
+
+        // records older than the window are not expected to be preceded by those still in the rings
+        std::sort(pending.begin(), pending.end());
+        const uint64_t limit = arx::debug::shm_ring::now_ns() - window_ns;
+        auto end = pending.begin();
+        while (end != pending.end() && (b_last || end->time_ns <= limit)) write_entry(os, *end++, opt.b_pid);
+        pending.erase(pending.begin(), end);
+        os.flush();
+
+        if (b_last) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(opt.interval_ms));
+    }
+}